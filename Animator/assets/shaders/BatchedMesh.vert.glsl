@@ -0,0 +1,44 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+void LoadVertex(out vec3 position, out vec3 normal, out vec2 texCoords);
+
+// One per command of the multi-draw, the command index is gl_DrawIDARB
+struct Draw
+{
+	mat4 transform;
+	vec4 color;
+	float timeOffset;
+};
+
+layout (std430, binding=0) readonly buffer Draws
+{
+	Draw draws[];
+};
+
+const float SPIN_SPEED = 1.5;
+const float BOB_SPEED = 2.0;
+const float BOB_HEIGHT = 0.25;
+
+out vec2 v_TexCoords;
+out vec4 v_Color;
+
+void main()
+{
+	vec3 position;
+	vec3 normal;
+	LoadVertex(position, normal, v_TexCoords);
+
+	// The same animation as InstancedMesh.vert.glsl
+	Draw draw = draws[gl_DrawIDARB];
+	float time = u_Time + draw.timeOffset;
+	float s = sin(time * SPIN_SPEED);
+	float c = cos(time * SPIN_SPEED);
+	position = vec3(c * position.x + s * position.z, position.y + sin(time * BOB_SPEED) * BOB_HEIGHT, c * position.z - s * position.x);
+	normal = vec3(c * normal.x + s * normal.z, normal.y, c * normal.z - s * normal.x);
+
+	mat4 modelMatrix = u_ModelMatrix * draw.transform;
+	float shade = 0.4 + 0.6 * abs(normalize(mat3(modelMatrix) * normal).z);
+	v_Color = vec4(draw.color.rgb * shade, draw.color.a);
+	gl_Position = u_ViewProjectionMatrix * modelMatrix * vec4(position, 1.0);
+}
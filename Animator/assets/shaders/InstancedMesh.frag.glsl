@@ -0,0 +1,13 @@
+#version 430
+
+uniform sampler2D u_Texture;
+
+in vec2 v_TexCoords;
+in vec4 v_Color;
+
+out vec4 FragColor;
+
+void main()
+{
+	FragColor = texture(u_Texture, v_TexCoords) * v_Color;
+}
@@ -0,0 +1,34 @@
+#version 430
+
+void LoadVertex(out vec3 position, out vec3 normal, out vec2 texCoords);
+
+layout (location=3) in mat4 a_InstanceTransform;
+layout (location=7) in vec4 a_InstanceColor;
+layout (location=8) in float a_InstanceTimeOffset;
+
+const float SPIN_SPEED = 1.5;
+const float BOB_SPEED = 2.0;
+const float BOB_HEIGHT = 0.25;
+
+out vec2 v_TexCoords;
+out vec4 v_Color;
+
+void main()
+{
+	vec3 position;
+	vec3 normal;
+	LoadVertex(position, normal, v_TexCoords);
+
+	// Every instance spins around its y axis and bobs, the time offset shifts the phase
+	float time = u_Time + a_InstanceTimeOffset;
+	float s = sin(time * SPIN_SPEED);
+	float c = cos(time * SPIN_SPEED);
+	position = vec3(c * position.x + s * position.z, position.y + sin(time * BOB_SPEED) * BOB_HEIGHT, c * position.z - s * position.x);
+	normal = vec3(c * normal.x + s * normal.z, normal.y, c * normal.z - s * normal.x);
+
+	// Light from the viewer, just enough to tell the faces apart
+	mat4 modelMatrix = u_ModelMatrix * a_InstanceTransform;
+	float shade = 0.4 + 0.6 * abs(normalize(mat3(modelMatrix) * normal).z);
+	v_Color = vec4(a_InstanceColor.rgb * shade, a_InstanceColor.a);
+	gl_Position = u_ViewProjectionMatrix * modelMatrix * vec4(position, 1.0);
+}
@@ -0,0 +1,22 @@
+#version 430
+
+layout (points) in;
+layout (line_strip, max_vertices=2) out;
+
+in vec3 v_Normal[];
+
+uniform float u_NormalLength;
+
+void main()
+{
+	// Dividing by the scale keeps the line length independent of the model scale
+	vec3 position = gl_in[0].gl_Position.xyz;
+	vec3 end = position + v_Normal[0] * u_NormalLength / u_Scale.xyz;
+	mat4 matrix = u_ViewProjectionMatrix * u_ModelMatrix;
+
+	gl_Position = matrix * vec4(position, 1.0);
+	EmitVertex();
+	gl_Position = matrix * vec4(end, 1.0);
+	EmitVertex();
+	EndPrimitive();
+}
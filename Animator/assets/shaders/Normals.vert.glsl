@@ -1,11 +1,13 @@
 #version 430
 
-layout (location=0) in vec3 a_Position;
+void LoadVertex(out vec3 position, out vec3 normal, out vec2 texCoords);
 
-uniform mat4 u_ViewProjectionMatrix;
-uniform mat4 u_ModelMatrix;
+out vec3 v_Normal;
 
 void main()
 {
-	gl_Position = u_ViewProjectionMatrix * u_ModelMatrix * vec4(a_Position, 1.0);
+	vec3 position;
+	vec2 texCoords;
+	LoadVertex(position, v_Normal, texCoords);
+	gl_Position = vec4(position, 1.0);
 }
\ No newline at end of file
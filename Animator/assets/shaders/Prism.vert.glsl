@@ -0,0 +1,80 @@
+#version 430
+
+// Vertex source of the mesh shaders, linked with them as a second vertex shader.
+// With u_PrismN set the vertex is computed from gl_VertexID as the non-indexed
+// vertex gl_VertexID of a prism with u_PrismN sides, keep in sync with
+// Mesh::GetProceduralPrismVertex. The uniform blocks are declared by the
+// application in front of every shader, see FrameUniforms and ObjectUniforms
+
+layout (location=0) in vec3 a_Position;
+layout (location=1) in vec3 a_Normal;
+layout (location=2) in vec2 a_TexCoords;
+
+const float PI = 3.14159265358979;
+const float PRISM_START_T = -3.0 * PI / 4.0;
+const float PRISM_HEIGHT = 0.5;
+const float PRISM_RADIUS = sqrt(0.5) / 2.0;
+
+// Side quad corner of each of its six indices: previous bottom, previous top, next bottom, next top
+const uint SIDE_CORNERS[6] = uint[6](0u, 1u, 2u, 2u, 1u, 3u);
+
+vec2 GetCirclePoint(uint i)
+{
+	float t = 2.0 * PI / float(u_PrismN) * float(i % u_PrismN) + PRISM_START_T;
+	return vec2(cos(t), sin(t));
+}
+
+void LoadVertex(out vec3 position, out vec3 normal, out vec2 texCoords)
+{
+	if (u_PrismN == 0u)
+	{
+		position = a_Position;
+		normal = a_Normal;
+		texCoords = a_TexCoords;
+		return;
+	}
+
+	uint n = u_PrismN;
+	uint index = uint(gl_VertexID);
+	if (index < 6u * n)
+	{
+		uint segment = index / 6u;
+		uint corner = SIDE_CORNERS[index % 6u];
+		vec2 previousPoint = GetCirclePoint(segment);
+		vec2 nextPoint = GetCirclePoint(segment + 1u);
+		vec2 previous = PRISM_RADIUS * previousPoint;
+		vec2 next = PRISM_RADIUS * nextPoint;
+		vec2 bisector = previousPoint + nextPoint;
+		normal = normalize(vec3(bisector.x, 0.0, bisector.y));
+
+		bool top = corner == 1u || corner == 3u;
+		uint point = corner < 2u ? segment : segment + 1u;
+		vec2 rim = corner < 2u ? previous : next;
+		position = vec3(rim.x, top ? PRISM_HEIGHT / 2.0 : -PRISM_HEIGHT / 2.0, rim.y);
+		texCoords = vec2(float(point) / float(n), top ? 0.5 : 0.0);
+		return;
+	}
+
+	index -= 6u * n;
+	bool top = index < 3u * n;
+	if (!top)
+	{
+		index -= 3u * n;
+	}
+
+	uint segment = index / 3u;
+	uint corner = index % 3u;
+	float y = top ? PRISM_HEIGHT / 2.0 : -PRISM_HEIGHT / 2.0;
+	vec2 centerUV = top ? vec2(0.25, 0.75) : vec2(0.75, 0.75);
+	normal = vec3(0.0, top ? 1.0 : -1.0, 0.0);
+	if (corner == 0u)
+	{
+		position = vec3(0.0, y, 0.0);
+		texCoords = centerUV;
+		return;
+	}
+
+	vec2 point = GetCirclePoint(corner == 1u ? segment + 1u : segment);
+	position = vec3(PRISM_RADIUS * point.x, y, PRISM_RADIUS * point.y);
+	texCoords = 0.25 * point + centerUV;
+}
\ No newline at end of file
@@ -1,16 +1,13 @@
 #version 430
 
-layout (location=0) in vec3 a_Position;
-layout (location=1) in vec3 a_Normal;
-layout (location=2) in vec2 a_TexCoords;
-
-uniform mat4 u_ViewProjectionMatrix;
-uniform mat4 u_ModelMatrix;
+void LoadVertex(out vec3 position, out vec3 normal, out vec2 texCoords);
 
 out vec2 v_TexCoords;
 
 void main()
 {
-	v_TexCoords = a_TexCoords;
-	gl_Position = u_ViewProjectionMatrix * u_ModelMatrix * vec4(a_Position, 1.0);
+	vec3 position;
+	vec3 normal;
+	LoadVertex(position, normal, v_TexCoords);
+	gl_Position = u_ViewProjectionMatrix * u_ModelMatrix * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <memory>
 #include <chrono>
+#include <algorithm>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <Windows.h>
@@ -31,11 +32,21 @@
 #include "Debug.hpp"
 #include "scene/Scene.hpp"
 #include "mesh/Mesh.hpp"
+#include "mesh/PrismCache.hpp"
+#include "mesh/PrismBuilder.hpp"
 #include "MathConstants.hpp"
 #include "CustomUI.hpp"
 #include "renderer/Shader.hpp"
 #include "renderer/Camera.hpp"
+#include "renderer/StreamingBuffer.hpp"
+#include "renderer/VertexArray.hpp"
+#include "renderer/UniformBlock.hpp"
+#include "renderer/RenderState.hpp"
+#include "renderer/RenderQueue.hpp"
+#include "renderer/StorageBuffer.hpp"
+#include "renderer/ProgramCache.hpp"
 #include "Resources.hpp"
+#include "jobs/JobSystem.hpp"
 
 const int SCREEN_WIDTH = 1000;
 const int SCREEN_HEIGHT = 1000;
@@ -47,7 +58,12 @@ const float SCALE_MIN = 0.5f;
 const float SCALE_MAX = 2.0f;
 
 const int MIN_N = 3;
-const int MAX_N = 1000;
+const int MAX_N = 2000000;
+
+const float NORMAL_LENGTH = 0.4f;
+
+// Relative to the working directory, like the assets
+const char* PROGRAM_CACHE_DIRECTORY = "ProgramCache";
 
 const char* MODE_NAMES[] = { "Wireframe", "Color", "Texture" };
 const int MODES_COUNT = sizeof(MODE_NAMES) / sizeof(char*);
@@ -57,6 +73,11 @@ std::vector<std::shared_ptr<Window>> windows;
 std::shared_ptr<Shader> unlitMeshShader;
 std::shared_ptr<Shader> litMeshShader;
 std::shared_ptr<Shader> normalShader;
+std::shared_ptr<Shader> instancedMeshShader;
+// Null without GL_ARB_shader_draw_parameters
+std::shared_ptr<Shader> batchedMeshShader;
+std::unique_ptr<StreamingBuffer> streamingBuffer;
+RenderQueue renderQueue;
 Camera camera(SCREEN_WIDTH, SCREEN_HEIGHT, { 0.0f, 0.0f, 1.0f });
 
 void SetupViewport(int width, int height)
@@ -111,6 +132,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 
 	Scene& scene = Scene::Current();
 	Animator& animator = scene.GetAnimator();
+	const Scene::PropertyIds& propertyIds = scene.GetPropertyIds();
 	glm::vec3& rotation = scene.Rotation;
 	glm::vec3& position = scene.Position;
 	glm::vec3& scale = scene.Scale;
@@ -129,7 +151,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	case GLFW_KEY_H:
 	case GLFW_KEY_U:
 	case GLFW_KEY_J:
-		if (animator.IsDriven(Scene::ROTATION_PROPERTY_NAME))
+		if (animator.IsDriven(propertyIds.Rotation))
 		{
 			return;
 		}
@@ -140,14 +162,14 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
 	case GLFW_KEY_D:
 	case GLFW_KEY_Z:
 	case GLFW_KEY_X:
-		if (animator.IsDriven(Scene::POSITION_PROPERTY_NAME))
+		if (animator.IsDriven(propertyIds.Position))
 		{
 			return;
 		}
 		break;
 	case GLFW_KEY_E:
 	case GLFW_KEY_Q:
-		if (animator.IsDriven(Scene::SCALE_PROPERTY_NAME))
+		if (animator.IsDriven(propertyIds.Scale))
 		{
 			return;
 		}
@@ -208,15 +230,15 @@ void DrawLightingWindow()
 	ImGui::Begin("Lighting");
 	ImGui::Checkbox("Enabled", &scene.Lightning);
 
-	CustomUI::BeginDrivenRegion(Scene::AMBIENT_COLOR_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().AmbientColor);
 	ImGui::ColorEdit3(Scene::AMBIENT_COLOR_PROPERTY_NAME.c_str(), &scene.AmbientColor[0]);
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::DIFFUSE_COLOR_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().DiffuseColor);
 	ImGui::ColorEdit3(Scene::DIFFUSE_COLOR_PROPERTY_NAME.c_str(), &scene.DiffuseColor[0]);
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::LIGHT_SPECULAR_COLOR_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().LightSpecularColor);
 	ImGui::ColorEdit3(Scene::LIGHT_SPECULAR_COLOR_PROPERTY_NAME.c_str(), &scene.LightSpecularColor[0]);
 	CustomUI::EndDrivenRegion();
 
@@ -228,11 +250,11 @@ void DrawTransformWindow()
 	Scene& scene = Scene::Current();
 	ImGui::Begin("Transform");
 	
-	CustomUI::BeginDrivenRegion(Scene::POSITION_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().Position);
 	ImGui::DragFloat3(Scene::POSITION_PROPERTY_NAME.c_str(), &scene.Position[0], POSITION_CHANGE);
 	CustomUI::EndDrivenRegion();
 	
-	CustomUI::BeginDrivenRegion(Scene::ROTATION_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().Rotation);
 	if (ImGui::DragFloat3(Scene::ROTATION_PROPERTY_NAME.c_str(), &scene.Rotation[0], ROTATION_CHANGE))
 	{
 		for (size_t i = 0; i < 3; i++)
@@ -242,7 +264,7 @@ void DrawTransformWindow()
 	}
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::SCALE_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().Scale);
 	ImGui::DragFloat3(Scene::SCALE_PROPERTY_NAME.c_str(), &scene.Scale[0], SCALE_CHANGE);
 	CustomUI::EndDrivenRegion();
 
@@ -285,7 +307,7 @@ void DrawPrismWindow(GLFWwindow* window)
 		scene.RenderMode = (RenderMode)modeIndex;
 	}
 
-	CustomUI::BeginDrivenRegion(Scene::N_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().N);
 	int n = scene.GetN();
 	if (ImGui::DragInt(Scene::N_PROPERTY_NAME.c_str(), &n, 1.0f, MIN_N, MAX_N))
 	{
@@ -293,20 +315,50 @@ void DrawPrismWindow(GLFWwindow* window)
 	}
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::PRISM_COLOR_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().PrismColor);
 	ImGui::ColorEdit3(Scene::PRISM_COLOR_PROPERTY_NAME.c_str(), &scene.PrismColor[0]);
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::PRISM_SPECULAR_COLOR_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().PrismSpecularColor);
 	ImGui::ColorEdit3(Scene::PRISM_SPECULAR_COLOR_PROPERTY_NAME.c_str(), &scene.PrismSpecularColor[0]);
 	CustomUI::EndDrivenRegion();
 
-	CustomUI::BeginDrivenRegion(Scene::SHININESS_PROPERTY_NAME);
+	CustomUI::BeginDrivenRegion(scene.GetPropertyIds().Shininess);
 	ImGui::SliderFloat(Scene::SHININESS_PROPERTY_NAME.c_str(), &scene.Shininess, 0.0f, 128.0f);
 	CustomUI::EndDrivenRegion();
 
 	ImGui::Checkbox("Show normals", &scene.ShowNormals);
 
+	bool compact = scene.GetPrismVertexFormat() == Mesh::VertexFormat::Compact;
+	if (ImGui::Checkbox("Compact verticies", &compact))
+	{
+		scene.SetPrismVertexFormat(compact ? Mesh::VertexFormat::Compact : Mesh::VertexFormat::Full);
+	}
+
+	bool procedural = scene.IsPrismProcedural();
+	if (ImGui::Checkbox("Procedural prism", &procedural))
+	{
+		scene.SetPrismProcedural(procedural);
+	}
+
+	bool instanced = scene.IsInstanced();
+	if (ImGui::Checkbox("Instanced", &instanced))
+	{
+		scene.SetInstanced(instanced);
+	}
+
+	bool varyingN = scene.IsInstancesVaryingN();
+	if (ImGui::Checkbox("Varying N", &varyingN))
+	{
+		scene.SetInstancesVaryingN(varyingN);
+	}
+
+	int instancesCount = scene.GetInstancesCount();
+	if (ImGui::DragInt("Instances", &instancesCount, 100.0f, 0, Scene::MAX_INSTANCES, "%d", ImGuiSliderFlags_AlwaysClamp))
+	{
+		scene.SetInstancesCount(instancesCount);
+	}
+
 	ImGui::End();
 }
 
@@ -474,10 +526,123 @@ void DrawDockSpace(GLFWwindow* window)
 	DrawUI(window);
 }
 
-void DrawNormals(const glm::mat4& modelMatrix)
+#define FRAME_UNIFORMS_FIELDS(FIELD) \
+	FIELD(glm::mat4, ViewProjectionMatrix) \
+	FIELD(glm::mat4, ViewMatrix) \
+	FIELD(glm::mat4, ProjectionMatrix) \
+	FIELD(glm::vec4, LightAmbient) \
+	FIELD(glm::vec4, LightDiffuse) \
+	FIELD(glm::vec4, LightSpecular) \
+	/* Seconds since start, drives the instance animation */ \
+	FIELD(float, Time) \
+	FIELD(float, TimePadding0) \
+	FIELD(float, TimePadding1) \
+	FIELD(float, TimePadding2)
+
+#define OBJECT_UNIFORMS_FIELDS(FIELD) \
+	FIELD(glm::mat4, ModelMatrix) \
+	FIELD(glm::mat3x4, NormalMatrix) \
+	FIELD(glm::vec4, Color) \
+	FIELD(glm::vec4, Scale) \
+	FIELD(glm::vec4, SpecularColor) \
+	FIELD(float, Shininess) \
+	/* Non-zero draws the prism procedurally, see Prism.vert.glsl */ \
+	FIELD(uint32_t, PrismN) \
+	FIELD(uint32_t, Padding0) \
+	FIELD(uint32_t, Padding1)
+
+// Shared by all programs, bound once per frame
+DECLARE_UNIFORM_BLOCK(FrameUniforms, 0, FRAME_UNIFORMS_FIELDS)
+DECLARE_UNIFORM_BLOCK(ObjectUniforms, 1, OBJECT_UNIFORMS_FIELDS)
+
+// Rebuilt only when the camera or the lighting changes
+FrameUniforms frameUniforms;
+size_t frameUniformsCameraVersion = 0;
+size_t frameUniformsLightingVersion = 0;
+
+void StreamFrameUniforms()
+{
+	const Scene& scene = Scene::Current();
+	if (frameUniformsCameraVersion != camera.GetVersion())
+	{
+		frameUniforms.ViewProjectionMatrix = camera.ViewProjectionMatrix();
+		frameUniforms.ViewMatrix = camera.ViewMatrix();
+		frameUniforms.ProjectionMatrix = camera.ProjectionMatrix();
+		frameUniformsCameraVersion = camera.GetVersion();
+	}
+
+	if (frameUniformsLightingVersion != scene.GetLightingVersion())
+	{
+		frameUniforms.LightAmbient = scene.AmbientColor;
+		frameUniforms.LightDiffuse = scene.DiffuseColor;
+		frameUniforms.LightSpecular = scene.LightSpecularColor;
+		frameUniformsLightingVersion = scene.GetLightingVersion();
+	}
+
+	frameUniforms.Time = float(glfwGetTime());
+	frameUniforms.TimePadding0 = 0.0f;
+	frameUniforms.TimePadding1 = 0.0f;
+	frameUniforms.TimePadding2 = 0.0f;
+
+	StreamingBuffer::Allocation allocation = streamingBuffer->AllocateUniform(&frameUniforms, sizeof(frameUniforms));
+	streamingBuffer->BindRange(GL_UNIFORM_BUFFER, FrameUniforms::BINDING, allocation);
+}
+
+// Instances with varying N are drawn as a batch of meshes, falling back to
+// procedural instances with the scene N when the batch shader is missing
+bool IsSceneBatched()
+{
+	const Scene& scene = Scene::Current();
+	return scene.IsInstanced() && scene.IsInstancesVaryingN() && batchedMeshShader;
+}
+
+StreamingBuffer::Allocation StreamObjectUniforms()
+{
+	Scene& scene = Scene::Current();
+	const Transform& transform = scene.GetTransform();
+
+	ObjectUniforms uniforms;
+	uniforms.ModelMatrix = transform.GetMatrix();
+	uniforms.NormalMatrix = glm::mat3x4(transform.GetNormalMatrix());
+	uniforms.Color = glm::vec4(scene.PrismColor, 1.0f);
+	uniforms.Scale = glm::vec4(transform.GetScale(), 1.0f);
+	uniforms.SpecularColor = scene.PrismSpecularColor;
+	uniforms.Shininess = std::max(scene.Shininess, 0.1f);
+	uniforms.PrismN = scene.IsPrismProcedural() || (scene.IsInstanced() && !IsSceneBatched()) ? scene.GetN() : 0;
+	uniforms.Padding0 = 0;
+	uniforms.Padding1 = 0;
+
+	return streamingBuffer->AllocateUniform(&uniforms, sizeof(uniforms));
+}
+
+RenderQueue::GLBackend renderBackend(ObjectUniforms::BINDING);
+
+unsigned int GetPolygonMode()
+{
+	return Scene::Current().RenderMode == RenderMode::Wireframe ? GL_LINE : GL_FILL;
+}
+
+RenderQueue::Item CreateRenderItem(
+	const Shader& shader,
+	const RenderQueue::Geometry& geometry,
+	const StreamingBuffer::Allocation& objectUniforms
+)
+{
+	RenderQueue::Item item;
+	item.program = shader.GetId();
+	item.geometry = geometry;
+	item.texture = 0;
+	item.polygonMode = GetPolygonMode();
+	item.uniformBuffer = streamingBuffer->GetId();
+	item.uniformOffset = objectUniforms.offset;
+	item.uniformSize = objectUniforms.size;
+	return item;
+}
+
+void SubmitNormals(const StreamingBuffer::Allocation& objectUniforms)
 {
 	Scene& scene = Scene::Current();
-	if (!scene.ShowNormals)
+	if (!scene.ShowNormals || scene.IsInstanced())
 	{
 		return;
 	}
@@ -490,28 +655,10 @@ void DrawNormals(const glm::mat4& modelMatrix)
 		}
 	}
 
-	Mesh& prism = scene.GetPrism();
-	normalShader->Use();
-	normalShader->SetUniform("u_ViewProjectionMatrix", camera.ViewProjectionMatrix());
-	normalShader->SetUniform("u_ModelMatrix", modelMatrix);
-	prism.DrawNormals(scene.Scale);
-}
-
-void UpdateRenderPolygonMode()
-{
-	const Scene& scene = Scene::Current();
-	switch (scene.RenderMode)
-	{
-	case RenderMode::Wireframe:
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		break;
-	case RenderMode::Color:
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		break;
-	case RenderMode::Texture:
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-		break;
-	}
+	const RenderQueue::Geometry geometry = scene.IsPrismProcedural()
+		? Mesh::GetProceduralPrismGeometry(scene.GetN(), GL_POINTS)
+		: scene.GetPrism().GetNormalsGeometry();
+	renderQueue.Submit(CreateRenderItem(*normalShader, geometry, objectUniforms));
 }
 
 void BeginPrism()
@@ -535,50 +682,177 @@ void BeginPrism()
 	}
 }
 
-void DrawPrism(const glm::mat4& modelMatrix)
+// Instance attributes follow the vertex attributes of Prism.vert.glsl
+const size_t INSTANCE_ATTRIBUTES_LOCATION = 3;
+
+std::unique_ptr<VertexBuffer> instanceBuffer;
+std::unique_ptr<VertexArray> instanceVertexArray;
+size_t uploadedInstancesVersion = 0;
+
+void UpdateInstanceBuffer()
 {
-	static std::shared_ptr<Texture> whiteTexture = Texture::White();
-	Scene& scene = Scene::Current();
-	Mesh& prism = scene.GetPrism();
-	
-	if (scene.RenderMode == RenderMode::Texture)
+	const Scene& scene = Scene::Current();
+	if (uploadedInstancesVersion == scene.GetInstancesVersion())
 	{
-		scene.Texture->Bind();
+		return;
 	}
-	else
+
+	static const BufferLayout layout({
+		BufferElement(BufferElement::Type::Mat4, "a_InstanceTransform", false),
+		BufferElement(BufferElement::Type::Float4, "a_InstanceColor", false),
+		BufferElement(BufferElement::Type::Float, "a_InstanceTimeOffset", false)
+	});
+
+	const std::vector<Scene::Instance>& instances = scene.GetInstances();
+	instanceVertexArray.reset();
+	instanceBuffer.reset(new VertexBuffer((void*)instances.data(), instances.size() * sizeof(Scene::Instance), layout));
+	instanceVertexArray.reset(new VertexArray());
+	instanceVertexArray->SetNextAttribIndex(INSTANCE_ATTRIBUTES_LOCATION);
+	instanceVertexArray->AddVertexBuffer(*instanceBuffer, 1);
+	uploadedInstancesVersion = scene.GetInstancesVersion();
+}
+
+void SubmitInstances(const StreamingBuffer::Allocation& objectUniforms, unsigned int texture)
+{
+	const Scene& scene = Scene::Current();
+	if (scene.GetInstances().empty())
 	{
-		whiteTexture->Bind();
+		return;
 	}
 
-	if (scene.Lightning)
+	UpdateInstanceBuffer();
+	RenderQueue::Geometry geometry = Mesh::GetProceduralPrismGeometry(scene.GetN(), GL_TRIANGLES);
+	geometry.vertexArray = instanceVertexArray->GetId();
+	geometry.instanceCount = scene.GetInstances().size();
+
+	RenderQueue::Item item = CreateRenderItem(*instancedMeshShader, geometry, objectUniforms);
+	item.texture = texture;
+	renderQueue.Submit(item);
+}
+
+// Per draw data of BatchedMesh.vert.glsl, laid out as std430
+struct BatchedDraw
+{
+	glm::mat4 Transform;
+	glm::vec4 Color;
+	float TimeOffset;
+	float Padding[3];
+};
+
+static_assert(sizeof(BatchedDraw) == 96, "BatchedDraw does not match the std430 layout of Draw");
+
+const unsigned int BATCHED_DRAWS_BINDING = 0;
+// Besides the uniforms, every frame streams the commands of up to Scene::MAX_INSTANCES batched instances
+const size_t STREAMING_REGION_SIZE = StreamingBuffer::DEFAULT_REGION_SIZE + size_t(Scene::MAX_INSTANCES) * sizeof(RenderQueue::IndirectCommand);
+
+std::unique_ptr<StorageBuffer> batchedDrawsBuffer;
+// Indexed by N, keeps the meshes in the arena while batched. Every prism up
+// to Scene::VARYING_N_MAX has 16-bit indices, so one multi-draw covers all
+std::vector<std::shared_ptr<Mesh>> batchedMeshes;
+Mesh::VertexFormat batchedMeshesFormat = Mesh::VertexFormat::Full;
+size_t uploadedBatchVersion = 0;
+
+void UpdateBatch()
+{
+	const Scene& scene = Scene::Current();
+	if (batchedMeshes.empty() || batchedMeshesFormat != scene.GetPrismVertexFormat())
 	{
-		litMeshShader->Use();
-		litMeshShader->SetUniform("u_LightInfo.Ambient", scene.AmbientColor);
-		litMeshShader->SetUniform("u_LightInfo.Diffuse", scene.DiffuseColor);
-		litMeshShader->SetUniform("u_LightInfo.Specular", scene.LightSpecularColor);
-		litMeshShader->SetUniform("u_Material.Specular", scene.PrismSpecularColor);
-		float shininess = scene.Shininess;
-		if (shininess < 0.1f)
+		batchedMeshesFormat = scene.GetPrismVertexFormat();
+		batchedMeshes.assign(Scene::VARYING_N_MAX + 1, nullptr);
+		for (int n = Scene::VARYING_N_MIN; n <= Scene::VARYING_N_MAX; n++)
 		{
-			shininess = 0.1;
+			batchedMeshes[n] = PrismCache::Get(n, batchedMeshesFormat);
 		}
+	}
 
-		litMeshShader->SetUniform("u_Material.Shininess", shininess);
-		litMeshShader->SetUniform("u_ProjectionMatrix", camera.ProjectionMatrix());
-		litMeshShader->SetUniform("u_ViewMatrix", camera.ViewMatrix());
-		litMeshShader->SetUniform("u_ModelMatrix", modelMatrix);
-		litMeshShader->SetUniform("u_Color", scene.PrismColor);
-		litMeshShader->SetUniform("u_Texture", 0);
+	if (uploadedBatchVersion == scene.GetInstancesVersion())
+	{
+		return;
 	}
-	else
+
+	const std::vector<Scene::Instance>& instances = scene.GetInstances();
+	std::vector<BatchedDraw> draws(instances.size());
+	for (size_t i = 0; i < draws.size(); i++)
 	{
-		unlitMeshShader->Use();
-		unlitMeshShader->SetUniform("u_ViewProjectionMatrix", camera.ViewProjectionMatrix());
-		unlitMeshShader->SetUniform("u_ModelMatrix", modelMatrix);
-		unlitMeshShader->SetUniform("u_Color", scene.PrismColor);
-		unlitMeshShader->SetUniform("u_Texture", 0);
+		draws[i].Transform = instances[i].Transform;
+		draws[i].Color = instances[i].Color;
+		draws[i].TimeOffset = instances[i].TimeOffset;
+		draws[i].Padding[0] = 0.0f;
+		draws[i].Padding[1] = 0.0f;
+		draws[i].Padding[2] = 0.0f;
 	}
-	prism.Draw();
+
+	batchedDrawsBuffer.reset(new StorageBuffer(draws.data(), draws.size() * sizeof(BatchedDraw)));
+	uploadedBatchVersion = scene.GetInstancesVersion();
+}
+
+// One glMultiDrawElementsIndirect for all instances, the command of instance i
+// is built every frame into the streaming buffer and draws the mesh of its N
+void SubmitBatch(const StreamingBuffer::Allocation& objectUniforms, unsigned int texture)
+{
+	const Scene& scene = Scene::Current();
+	const std::vector<int>& instancesN = scene.GetInstancesN();
+	if (instancesN.empty())
+	{
+		return;
+	}
+
+	UpdateBatch();
+	const StreamingBuffer::Allocation commands = streamingBuffer->Allocate(
+		instancesN.size() * sizeof(RenderQueue::IndirectCommand),
+		sizeof(uint32_t)
+	);
+
+	RenderQueue::IndirectCommand* command = (RenderQueue::IndirectCommand*)commands.data;
+	for (size_t i = 0; i < instancesN.size(); i++)
+	{
+		command[i] = batchedMeshes[instancesN[i]]->GetIndirectCommand();
+	}
+
+	batchedDrawsBuffer->BindBase(BATCHED_DRAWS_BINDING);
+
+	RenderQueue::Geometry geometry = batchedMeshes[Scene::VARYING_N_MIN]->GetGeometry();
+	geometry.drawCount = instancesN.size();
+	geometry.indirectBuffer = streamingBuffer->GetId();
+	geometry.indirectOffset = commands.offset;
+
+	RenderQueue::Item item = CreateRenderItem(*batchedMeshShader, geometry, objectUniforms);
+	item.texture = texture;
+	renderQueue.Submit(item);
+}
+
+void SubmitPrism(const StreamingBuffer::Allocation& objectUniforms)
+{
+	static std::shared_ptr<Texture> whiteTexture = Texture::White();
+	Scene& scene = Scene::Current();
+	const unsigned int texture = scene.RenderMode == RenderMode::Texture ? scene.Texture->GetId() : whiteTexture->GetId();
+	if (IsSceneBatched())
+	{
+		SubmitBatch(objectUniforms, texture);
+		return;
+	}
+
+	if (scene.IsInstanced())
+	{
+		SubmitInstances(objectUniforms, texture);
+		return;
+	}
+
+	const Shader& shader = scene.Lightning ? *litMeshShader : *unlitMeshShader;
+	const RenderQueue::Geometry geometry = scene.IsPrismProcedural()
+		? Mesh::GetProceduralPrismGeometry(scene.GetN(), GL_TRIANGLES)
+		: scene.GetPrism().GetGeometry();
+
+	RenderQueue::Item item = CreateRenderItem(shader, geometry, objectUniforms);
+	item.texture = texture;
+	renderQueue.Submit(item);
+}
+
+void DrawRenderQueue()
+{
+	renderQueue.Sort();
+	renderQueue.Execute(renderBackend);
+	renderQueue.Clear();
 }
 
 void UpdateImGui(GLFWwindow* window, ImGuiIO& io)
@@ -627,14 +901,23 @@ void SetupCamera(GLFWwindow* window)
 	camera.SetPerspectiveProperties(70, 0.01f, 1000.0f);
 }
 
+std::string GetUniformBlocksDeclaration()
+{
+	return FrameUniforms::GetDeclaration() + ObjectUniforms::GetDeclaration();
+}
+
 void CreateNormalShader()
 {
 	normalShader = std::make_shared<Shader>();
 	try
 	{
+		normalShader->AddPrelude(GetUniformBlocksDeclaration());
 		normalShader->Add(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Normals.vert.glsl"));
+		normalShader->AddLibrary(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Prism.vert.glsl"));
+		normalShader->Add(GL_GEOMETRY_SHADER, Resources::LoadText("assets/shaders/Normals.geom.glsl"));
 		normalShader->Add(GL_FRAGMENT_SHADER, Resources::LoadText("assets/shaders/Normals.frag.glsl"));
 		normalShader->Link();
+		normalShader->SetUniform("u_NormalLength", NORMAL_LENGTH);
 	}
 	catch (std::runtime_error error)
 	{
@@ -648,9 +931,12 @@ void CreateUnlitMeshShader()
 	unlitMeshShader = std::make_shared<Shader>();
 	try
 	{
+		unlitMeshShader->AddPrelude(GetUniformBlocksDeclaration());
 		unlitMeshShader->Add(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/UnlitMesh.vert.glsl"));
+		unlitMeshShader->AddLibrary(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Prism.vert.glsl"));
 		unlitMeshShader->Add(GL_FRAGMENT_SHADER, Resources::LoadText("assets/shaders/UnlitMesh.frag.glsl"));
 		unlitMeshShader->Link();
+		unlitMeshShader->SetUniform("u_Texture", 0);
 	}
 	catch (std::runtime_error error)
 	{
@@ -664,9 +950,56 @@ void CreateLitMeshShader()
 	litMeshShader = std::make_shared<Shader>();
 	try
 	{
+		litMeshShader->AddPrelude(GetUniformBlocksDeclaration());
 		litMeshShader->Add(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/LitMesh.vert.glsl"));
+		litMeshShader->AddLibrary(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Prism.vert.glsl"));
 		litMeshShader->Add(GL_FRAGMENT_SHADER, Resources::LoadText("assets/shaders/LitMesh.frag.glsl"));
 		litMeshShader->Link();
+		litMeshShader->SetUniform("u_Texture", 0);
+	}
+	catch (std::runtime_error error)
+	{
+		std::cerr << error.what() << std::endl;
+		throw;
+	}
+}
+
+void CreateInstancedMeshShader()
+{
+	instancedMeshShader = std::make_shared<Shader>();
+	try
+	{
+		instancedMeshShader->AddPrelude(GetUniformBlocksDeclaration());
+		instancedMeshShader->Add(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/InstancedMesh.vert.glsl"));
+		instancedMeshShader->AddLibrary(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Prism.vert.glsl"));
+		instancedMeshShader->Add(GL_FRAGMENT_SHADER, Resources::LoadText("assets/shaders/InstancedMesh.frag.glsl"));
+		instancedMeshShader->Link();
+		instancedMeshShader->SetUniform("u_Texture", 0);
+	}
+	catch (std::runtime_error error)
+	{
+		std::cerr << error.what() << std::endl;
+		throw;
+	}
+}
+
+void CreateBatchedMeshShader()
+{
+	if (!GLEW_ARB_shader_draw_parameters)
+	{
+		Debug::LogWarning("GL_ARB_shader_draw_parameters is not supported, instances with varying N are drawn with the scene N");
+		return;
+	}
+
+	batchedMeshShader = std::make_shared<Shader>();
+	try
+	{
+		batchedMeshShader->AddPrelude(GetUniformBlocksDeclaration());
+		batchedMeshShader->Add(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/BatchedMesh.vert.glsl"));
+		batchedMeshShader->AddLibrary(GL_VERTEX_SHADER, Resources::LoadText("assets/shaders/Prism.vert.glsl"));
+		batchedMeshShader->Add(GL_FRAGMENT_SHADER, Resources::LoadText("assets/shaders/InstancedMesh.frag.glsl"));
+		batchedMeshShader->Link();
+		batchedMeshShader->SetUniform("u_Texture", 0);
 	}
 	catch (std::runtime_error error)
 	{
@@ -680,6 +1013,26 @@ void CreateShaders()
 	CreateNormalShader();
 	CreateUnlitMeshShader();
 	CreateLitMeshShader();
+	CreateInstancedMeshShader();
+	CreateBatchedMeshShader();
+}
+
+// Warm when every program came from the cache, cold when any was compiled
+void LogStartupTime(double startupTime, double shadersTime)
+{
+	const char* start = !ProgramCache::IsEnabled()
+		? "uncached"
+		: ProgramCache::GetMisses() == 0 ? "warm" : "cold";
+	Debug::LogFormat(
+		Debug::MessageType::Info,
+		"Startup (%s) - %.1f ms, shaders - %.1f ms. Programs loaded - %zu, compiled - %zu, rejected binaries - %zu",
+		start,
+		startupTime,
+		shadersTime,
+		ProgramCache::GetLoads(),
+		ProgramCache::GetMisses(),
+		ProgramCache::GetRejections()
+	);
 }
 
 #if _DEBUG
@@ -688,6 +1041,7 @@ int main()
 int WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
 #endif
 {
+	const auto startupStart = std::chrono::high_resolution_clock::now();
 	if (!glfwInit())
 	{
 		return -1;
@@ -708,18 +1062,27 @@ int WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
 		return false;
 	}
 
+	JobSystem::Initialize();
 	ImGuiIO& io = SetupImGui(window);
 	Scene::SetDefault();
  
+	ProgramCache::Initialize(PROGRAM_CACHE_DIRECTORY);
+	const auto shadersStart = std::chrono::high_resolution_clock::now();
 	CreateShaders();
+	const auto shadersStop = std::chrono::high_resolution_clock::now();
+	streamingBuffer.reset(new StreamingBuffer(STREAMING_REGION_SIZE));
 	SetupCamera(window);
 	glEnable(GL_DEPTH_TEST);
 
 	windows.push_back(std::shared_ptr<Window>(new DebugWindow()));
 	windows.push_back(std::shared_ptr<Window>(new AnimatorWindow()));
-	windows.push_back(std::shared_ptr<Window>(new PerformanceWindow()));
+	windows.push_back(std::shared_ptr<Window>(new PerformanceWindow(renderQueue, *streamingBuffer)));
 
 	PerformanceWindow::Data performanceData;
+	LogStartupTime(
+		std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startupStart).count(),
+		std::chrono::duration<double, std::milli>(shadersStop - shadersStart).count()
+	);
 
 	double lastFrameTime = 0.0;
 	while (!glfwWindowShouldClose(window))
@@ -737,19 +1100,19 @@ int WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
 		Scene& scene = Scene::Current();
 		Animator& animator = scene.GetAnimator();
 		animator.Update(float(currentFrameTime - lastFrameTime) * scene.TimeScale);
-		UpdateRenderPolygonMode();
+		scene.Sync();
 		auto stop = std::chrono::high_resolution_clock::now();
 		updateTime = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
 
 		start = std::chrono::high_resolution_clock::now();
-		glm::mat4 matrix = glm::mat4(1.0f);
-		matrix = glm::translate(matrix, scene.Position);
-		matrix = glm::rotate(matrix, glm::radians(scene.Rotation[0]), glm::vec3(1.0f, 0.0f, 0.0f));
-		matrix = glm::rotate(matrix, glm::radians(scene.Rotation[1]), glm::vec3(0.0f, 1.0f, 0.0f));
-		matrix = glm::rotate(matrix, glm::radians(scene.Rotation[2]), glm::vec3(0.0f, 0.0f, 1.0f));
-		matrix = glm::scale(matrix, scene.Scale);
-		DrawNormals(matrix);
-		DrawPrism(matrix);
+		streamingBuffer->BeginFrame();
+		StreamFrameUniforms();
+		const StreamingBuffer::Allocation objectUniforms = StreamObjectUniforms();
+		SubmitNormals(objectUniforms);
+		SubmitPrism(objectUniforms);
+		DrawRenderQueue();
+		streamingBuffer->EndFrame();
+		RenderState::EndFrame();
 		stop = std::chrono::high_resolution_clock::now();
 		renderTime = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
 
@@ -762,13 +1125,23 @@ int WinMain(HINSTANCE hInst, HINSTANCE hInstPrev, PSTR cmdline, int cmdshow)
 			updateTime,
 			renderTime,
 			uiTime,
-			1.0 / (currentFrameTime - lastFrameTime)
+			1.0 / (currentFrameTime - lastFrameTime),
+			streamingBuffer->GetFrameBytes()
 		);
 
 		glfwSwapBuffers(window);
 		lastFrameTime = currentFrameTime;
 	}
 
+	PrismBuilder::Clear();
+	PrismCache::Clear();
+	batchedMeshes.clear();
+	batchedDrawsBuffer.reset();
+	Mesh::ReleaseSharedObjects();
+	instanceVertexArray.reset();
+	instanceBuffer.reset();
+	streamingBuffer.reset();
+	JobSystem::Shutdown();
 	glfwTerminate();
 	return 0;
 }
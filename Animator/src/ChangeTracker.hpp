@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// Versions come from one counter, so a version remembered by a consumer
+// never matches a change of a different source
+inline size_t NextChangeVersion()
+{
+	static size_t version = 0;
+	return ++version;
+}
+
+// Keeps the last tracked value and takes a new version when it changes
+template<typename T>
+class ChangeTracker
+{
+private:
+	T value;
+	size_t version = 0;
+public:
+	bool Track(const T& value)
+	{
+		if (version != 0 && this->value == value)
+		{
+			return false;
+		}
+
+		this->value = value;
+		version = NextChangeVersion();
+		return true;
+	}
+
+	const T& GetValue() const { return value; }
+	size_t GetVersion() const { return version; }
+};
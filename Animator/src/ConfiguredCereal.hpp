@@ -11,3 +11,19 @@
 #include <cereal/types/memory.hpp>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/polymorphic.hpp>
+
+// Loads a field that files saved by older versions may not contain,
+// leaving the current value untouched when it is missing
+template<class Archive, class T>
+bool LoadOptionalNVP(Archive& archive, const char* name, T& value)
+{
+	try
+	{
+		archive(cereal::make_nvp(name, value));
+		return true;
+	}
+	catch (const cereal::Exception&)
+	{
+		return false;
+	}
+}
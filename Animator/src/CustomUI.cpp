@@ -132,6 +132,12 @@ void CustomUI::BeginDrivenRegion(const std::string propertyName)
 	BeginDisabledRegion(scene.GetAnimator().IsDriven(propertyName), "Driven by animator");
 }
 
+void CustomUI::BeginDrivenRegion(Animator::PropertyId propertyId)
+{
+	Scene& scene = Scene::Current();
+	BeginDisabledRegion(scene.GetAnimator().IsDriven(propertyId), "Driven by animator");
+}
+
 void CustomUI::EndDrivenRegion()
 {
 	EndDisabledRegion();
@@ -5,6 +5,8 @@
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
 
+#include "animation/Animator.hpp"
+
 namespace CustomUI
 {
 	void TextWithEllipsis(const char* text, const char* textEnd = 0, float clipWidth = 0.0f);
@@ -15,6 +17,8 @@ namespace CustomUI
 
 	void BeginDrivenRegion(const std::string propertyName);
 
+	void BeginDrivenRegion(Animator::PropertyId propertyId);
+
 	void EndDrivenRegion();
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
 const float PI = 3.14159265358979323846f;
+const double PI_DOUBLE = 3.14159265358979323846;
 const float DEG2RAD = PI / 180.0f;
 
@@ -10,18 +10,34 @@
 #include "animation/ParameterAnimationClip.hpp"
 #include "animation/Color3AnimationClip.hpp"
 #include "animation/Color4AnimationClip.hpp"
+#include "animation/ShininessAnimationClip.hpp"
+#include "animation/KeyframeTracks.hpp"
 
 CEREAL_REGISTER_TYPE(Vec3AnimationClip);
 CEREAL_REGISTER_TYPE(IntAnimationClip);
 CEREAL_REGISTER_TYPE(ParameterAnimationClip);
 CEREAL_REGISTER_TYPE(Color3AnimationClip);
 CEREAL_REGISTER_TYPE(Color4AnimationClip);
+CEREAL_REGISTER_TYPE(ShininessAnimationClip);
+CEREAL_REGISTER_TYPE(Vec3KeyframeTrack);
+CEREAL_REGISTER_TYPE(IntKeyframeTrack);
+CEREAL_REGISTER_TYPE(ParameterKeyframeTrack);
+CEREAL_REGISTER_TYPE(Color3KeyframeTrack);
+CEREAL_REGISTER_TYPE(Color4KeyframeTrack);
+CEREAL_REGISTER_TYPE(ShininessKeyframeTrack);
 
 CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Vec3AnimationClip);
 CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, ParameterAnimationClip);
 CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, IntAnimationClip);
 CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Color3AnimationClip);
 CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Color4AnimationClip);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, ShininessAnimationClip);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Vec3KeyframeTrack);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, IntKeyframeTrack);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, ParameterKeyframeTrack);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Color3KeyframeTrack);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, Color4KeyframeTrack);
+CEREAL_REGISTER_POLYMORPHIC_RELATION(AnimationClip, ShininessKeyframeTrack);
 
 namespace cereal
 {
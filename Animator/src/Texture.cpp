@@ -5,53 +5,105 @@
 #include <GL/glew.h>
 #include <stb_image/stb_image.h>
 #include "ConfiguredCereal.hpp"
+#include "renderer/RenderState.hpp"
 
-void Texture::LoadInCurrent(std::string path)
+struct Texture::Image
 {
-	stbi_set_flip_vertically_on_load(true);
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	stbi_uc* data = nullptr;
 
-	int width, height, channels;
-	stbi_uc* data = stbi_load(path.c_str(), &width, &height, &channels, 0);
+	~Image()
+	{
+		if (data != nullptr)
+		{
+			stbi_image_free(data);
+		}
+	}
+};
 
-	if (data == nullptr)
+void Texture::BeginLoad(std::string path)
+{
+	this->path = path;
+	std::shared_ptr<Image> image = std::make_shared<Image>();
+	this->image = image;
+	decodeJob = JobSystem::Run([image, path]()
+	{
+		stbi_set_flip_vertically_on_load_thread(true);
+		image->data = stbi_load(path.c_str(), &image->width, &image->height, &image->channels, 0);
+	});
+}
+
+void Texture::CompleteLoad()
+{
+	if (image == nullptr)
+	{
+		return;
+	}
+
+	JobSystem::Wait(decodeJob);
+	decodeJob = nullptr;
+	std::shared_ptr<Image> image = this->image;
+	this->image = nullptr;
+
+	if (image->data == nullptr)
 	{
 		throw std::exception("File not found");
 	}
 
-	glGenTextures(1, &id);
-	Bind();
-	if (channels == 3)
+	if (image->channels != 3 && image->channels != 4)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+		throw std::exception("Wrong channels");
 	}
-	else if (channels == 4)
+
+	// Created without binding, binds only go through RenderState
+	glCreateTextures(GL_TEXTURE_2D, 1, &id);
+	if (image->channels == 3)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		glTextureStorage2D(id, 1, GL_RGB8, image->width, image->height);
+		glTextureSubImage2D(id, 0, 0, 0, image->width, image->height, GL_RGB, GL_UNSIGNED_BYTE, image->data);
 	}
 	else
 	{
-		stbi_image_free(data);
-		throw std::exception("Wrong channels");
+		glTextureStorage2D(id, 1, GL_RGBA8, image->width, image->height);
+		glTextureSubImage2D(id, 0, 0, 0, image->width, image->height, GL_RGBA, GL_UNSIGNED_BYTE, image->data);
 	}
 
-	stbi_image_free(data);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-	this->width = width;
-	this->height = height;
-	this->path = path;
+	this->width = image->width;
+	this->height = image->height;
+}
+
+void Texture::LoadInCurrent(std::string path)
+{
+	BeginLoad(path);
+	CompleteLoad();
 }
 
 Texture::~Texture()
 {
+	if (decodeJob != nullptr)
+	{
+		try
+		{
+			JobSystem::Wait(decodeJob);
+		}
+		catch (const std::exception&)
+		{
+			// The image is dropped anyway
+		}
+	}
+
+	RenderState::ForgetTexture(id);
 	glDeleteTextures(1, &id);
 }
 
 void Texture::Bind(int slot) const
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, id);
+	RenderState::BindTexture(slot, id);
 }
 
 std::shared_ptr<Texture> Texture::Load(std::string path)
@@ -61,17 +113,34 @@ std::shared_ptr<Texture> Texture::Load(std::string path)
 	return texture;
 }
 
+std::vector<std::shared_ptr<Texture>> Texture::Load(const std::vector<std::string>& paths)
+{
+	std::vector<std::shared_ptr<Texture>> textures;
+	for (size_t i = 0; i < paths.size(); i++)
+	{
+		textures.push_back(std::make_shared<Texture>());
+		textures.back()->BeginLoad(paths[i]);
+	}
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		textures[i]->CompleteLoad();
+	}
+
+	return textures;
+}
+
 std::shared_ptr<Texture> Texture::White()
 {
 	std::shared_ptr<Texture> texture = std::make_shared<Texture>();
 
-	glGenTextures(1, &texture->id);
-	texture->Bind();
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture->id);
 	unsigned char data[] = { 255, 255, 255, 255 };
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	glTextureStorage2D(texture->id, 1, GL_RGBA8, 1, 1);
+	glTextureSubImage2D(texture->id, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture->id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture->id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	texture->width = 1;
 	texture->height = 1;
@@ -2,18 +2,28 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "ConfiguredCereal.hpp"
+#include "jobs/JobSystem.hpp"
 
 class Texture
 {
 private:
 	int width;
 	int height;
-	unsigned int id;
+	unsigned int id = 0;
 	std::string path;
 
+	struct Image;
+
+	std::shared_ptr<Image> image;
+	JobSystem::JobHandle decodeJob;
+
 	void LoadInCurrent(std::string path);
+
+	// Decodes the file on a worker, the pixels wait there for CompleteLoad
+	void BeginLoad(std::string path);
 public:
 	~Texture();
 
@@ -26,14 +36,21 @@ public:
 
 	void Bind(int slot = 0) const;
 
+	// Uploads the image decoded in the background, must be called on the
+	// context thread. Throws if the file could not be decoded
+	void CompleteLoad();
+
 	static std::shared_ptr<Texture> Load(std::string path);
 
+	// Images are decoded in parallel and uploaded on the calling thread
+	static std::vector<std::shared_ptr<Texture>> Load(const std::vector<std::string>& paths);
+
 	static std::shared_ptr<Texture> White();
 
 	template <class Archive>
 	std::string SaveMinimal(Archive const&) const { return path; }
 
 	template <class Archive>
-	void LoadMinimal(const Archive&, const std::string& value) { LoadInCurrent(value); }
+	void LoadMinimal(const Archive&, const std::string& value) { BeginLoad(value); }
 };
 
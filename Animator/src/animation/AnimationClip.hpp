@@ -8,6 +8,9 @@ class AnimationClip
 {
 private:
 	std::string propertyName;
+	size_t version = 0;
+protected:
+	void Invalidate() { version++; }
 public:
 	AnimationClip(const std::string& propertyName)
 		: propertyName(propertyName) { }
@@ -16,6 +19,8 @@ public:
 
 	const std::string& GetPropertyName() const { return propertyName; }
 
+	size_t GetVersion() const { return version; }
+
 	virtual void DrawUI() = 0;
 
 	template<class Archive>
@@ -1,42 +1,74 @@
 #include "Animator.hpp"
 
+#include <algorithm>
+#include <cfloat>
+
 const char* Animator::MODE_NAMES[] = { "Once", "Loop", "Ping pong" };
 const int Animator::MODES_COUNT = sizeof(Animator::MODE_NAMES) / sizeof(char*);
 
-void Animator::ActivatePropertyAnimation(const std::string& name)
+const char* Animator::CLIP_TYPE_NAMES[] = { "Bezier curve", "Keyframe track" };
+const int Animator::CLIP_TYPES_COUNT = sizeof(Animator::CLIP_TYPE_NAMES) / sizeof(char*);
+
+Animator::PropertyId Animator::AddProperty(Property&& animatorProperty)
 {
-	for (size_t i = 0; i < properties.size(); i++)
+	const PropertyId id = properties.size();
+	if (!propertyIds.emplace(animatorProperty.name, id).second)
 	{
-		if (properties[i]->GetName() == name)
-		{
-			if (properties[i]->AnimationActivated())
-			{
-				return;
-			}
+		throw std::runtime_error("Property \"" + animatorProperty.name + "\" is already registered");
+	}
 
-			properties[i]->ActivateAnimation();
-			animatedProperties.push_back(properties[i]);
-			break;
-		}
+	properties.push_back(std::move(animatorProperty));
+	drivenProperties.push_back(false);
+	return id;
+}
+
+Animator::PropertyId Animator::GetPropertyId(const std::string& name) const
+{
+	auto iterator = propertyIds.find(name);
+	return iterator == propertyIds.end() ? INVALID_PROPERTY_ID : iterator->second;
+}
+
+void Animator::ActivatePropertyAnimation(PropertyId id, ClipType type)
+{
+	if (id >= properties.size() || drivenProperties[id])
+	{
+		return;
 	}
+
+	Property& animatorProperty = properties[id];
+	animatorProperty.clip = animatorProperty.operations->CreateClip(animatorProperty, type);
+	animatedProperties.push_back(id);
+	drivenProperties[id] = true;
+	channelsDirty = true;
 }
 
-void Animator::DeactivatePropertyAnimation(const std::string& name)
+void Animator::ActivatePropertyAnimation(const std::string& name, ClipType type)
 {
-	for (size_t i = 0; i < animatedProperties.size(); i++)
+	ActivatePropertyAnimation(GetPropertyId(name), type);
+}
+
+void Animator::DeactivatePropertyAnimation(PropertyId id)
+{
+	if (id >= properties.size() || !drivenProperties[id])
 	{
-		if (animatedProperties[i]->GetName() == name)
-		{
-			animatedProperties[i]->DeactivateAnimation();
-			animatedProperties.erase(animatedProperties.begin() + i);
-			break;
-		}
+		return;
 	}
+
+	animatedProperties.erase(std::find(animatedProperties.begin(), animatedProperties.end(), id));
+	properties[id].clip = nullptr;
+
+	drivenProperties[id] = false;
+	channelsDirty = true;
+}
+
+void Animator::DeactivatePropertyAnimation(const std::string& name)
+{
+	DeactivatePropertyAnimation(GetPropertyId(name));
 }
 
 std::shared_ptr<AnimationClip> Animator::GetPropertyAnimation(size_t index)
 {
-	return animatedProperties[index]->GetAnimation();
+	return properties[animatedProperties[index]].clip;
 }
 
 void Animator::SetAnimationMode(Mode mode)
@@ -62,16 +94,16 @@ void Animator::SetAnimationTime(float value)
 	animationTime = value;
 }
 
-bool Animator::IsDriven(const std::string& propertyName) const
+bool Animator::ChannelsOutdated() const
 {
-	if (!Enabled)
+	if (channelsDirty || boundBaked != Baked)
 	{
-		return false;
+		return true;
 	}
 
-	for (size_t i = 0; i < animatedProperties.size(); i++)
+	for (size_t i = 0; i < boundClips.size(); i++)
 	{
-		if (animatedProperties[i]->GetName() == propertyName)
+		if (boundClips[i].first->GetVersion() != boundClips[i].second)
 		{
 			return true;
 		}
@@ -80,6 +112,44 @@ bool Animator::IsDriven(const std::string& propertyName) const
 	return false;
 }
 
+void Animator::BindChannels()
+{
+	evaluator.Clear();
+	boundClips.clear();
+	committedProperties.clear();
+	scalarProperties.clear();
+	channelsStartTime = FLT_MAX;
+	channelsEndTime = -FLT_MAX;
+	for (size_t i = 0; i < animatedProperties.size(); i++)
+	{
+		const PropertyId id = animatedProperties[i];
+		Property& animatorProperty = properties[id];
+		const AnimationClip* clip = animatorProperty.clip.get();
+		boundClips.push_back(std::make_pair(clip, clip->GetVersion()));
+		const ChannelBinding binding = animatorProperty.operations->BindChannels(animatorProperty, evaluator, Baked);
+		switch (binding)
+		{
+		case ChannelBinding::None:
+			scalarProperties.push_back(id);
+			break;
+		case ChannelBinding::Fields:
+			break;
+		case ChannelBinding::Committed:
+			committedProperties.push_back(id);
+			break;
+		}
+
+		if (binding != ChannelBinding::None)
+		{
+			channelsStartTime = std::min(channelsStartTime, animatorProperty.startTime);
+			channelsEndTime = std::max(channelsEndTime, animatorProperty.endTime);
+		}
+	}
+
+	channelsDirty = false;
+	boundBaked = Baked;
+}
+
 void Animator::SetCurrentTime(float value)
 {
 	if (value < 0.0f)
@@ -95,10 +165,17 @@ void Animator::SetCurrentTime(float value)
 	currentTime = value;
 }
 
+bool Animator::Settled(float from, float to, float startTime, float endTime)
+{
+	return (from <= startTime && to <= startTime) || (from >= endTime && to >= endTime);
+}
+
 void Animator::Update(float deltaTime)
 {
 	if (!Enabled)
 	{
+		// Fields may be edited meanwhile, so everything is written on enabling
+		evaluated = false;
 		return;
 	}
 
@@ -135,8 +212,38 @@ void Animator::Update(float deltaTime)
 		}
 	}
 
-	for (size_t i = 0; i < animatedProperties.size(); i++)
+	if (ChannelsOutdated())
 	{
-		animatedProperties[i]->Update(currentTime);
+		BindChannels();
+		evaluated = false;
 	}
+
+	// Driven values only change while the time moves inside a clip's range
+	if (evaluated && currentTime == evaluatedTime)
+	{
+		return;
+	}
+
+	if (!evaluated || !Settled(evaluatedTime, currentTime, channelsStartTime, channelsEndTime))
+	{
+		evaluator.Evaluate(currentTime);
+		evaluator.Scatter();
+		for (size_t i = 0; i < committedProperties.size(); i++)
+		{
+			Property& animatorProperty = properties[committedProperties[i]];
+			animatorProperty.operations->CommitChannels(animatorProperty, evaluator);
+		}
+	}
+
+	for (size_t i = 0; i < scalarProperties.size(); i++)
+	{
+		Property& animatorProperty = properties[scalarProperties[i]];
+		if (!evaluated || !Settled(evaluatedTime, currentTime, animatorProperty.startTime, animatorProperty.endTime))
+		{
+			animatorProperty.operations->Update(animatorProperty, currentTime);
+		}
+	}
+
+	evaluatedTime = currentTime;
+	evaluated = true;
 }
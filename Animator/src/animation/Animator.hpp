@@ -2,7 +2,8 @@
 
 #include <memory>
 #include <string>
-#include <functional>
+#include <cstdint>
+#include <stdexcept>
 #include <unordered_map>
 #include <type_traits>
 #include "../ConfiguredCereal.hpp"
@@ -10,6 +11,8 @@
 #include "../Debug.hpp"
 #include "AnimationClip.hpp"
 #include "TypedAnimationClip.hpp"
+#include "KeyframeTrack.hpp"
+#include "ChannelEvaluator.hpp"
 
 class Animator
 {
@@ -23,26 +26,74 @@ public:
 
 	static const char* MODE_NAMES[];
 	static const int MODES_COUNT;
+
+	// Index of a registered property, stable for the animator's lifetime
+	typedef size_t PropertyId;
+	static const PropertyId INVALID_PROPERTY_ID = SIZE_MAX;
+
+	enum class ClipType
+	{
+		Curve,
+		Keyframes
+	};
+
+	static const char* CLIP_TYPE_NAMES[];
+	static const int CLIP_TYPES_COUNT;
 private:
-	class Property
+	enum class ChannelBinding
+	{
+		None,
+		Fields,
+		Committed
+	};
+
+	static const int MAX_COMPONENTS = 4;
+
+	struct Property;
+
+	// Operations of one value type, clip type and store combination,
+	// generated once per combination by PropertyBinder
+	struct PropertyOperations
+	{
+		std::shared_ptr<AnimationClip> (*CreateClip)(const Property& animatorProperty, ClipType type);
+		std::shared_ptr<AnimationClip> (*CopyClip)(AnimationClip& clip);
+		void (*Update)(Property& animatorProperty, float time);
+		ChannelBinding (*BindChannels)(Property& animatorProperty, ChannelEvaluator& evaluator, bool baked);
+		void (*CommitChannels)(Property& animatorProperty, const ChannelEvaluator& evaluator);
+	};
+
+	// Properties live by value in one pool; their typed behaviour is
+	// reached through the shared operations table
+	struct Property
 	{
-	private:
 		std::string name;
-	public:
-		Property(const std::string& name) : name(name) { }
+		void* target;
+		const PropertyOperations* operations;
+		float defaultValue[MAX_COMPONENTS];
+		std::shared_ptr<AnimationClip> clip;
+		ChannelEvaluator::Channel channels[MAX_COMPONENTS];
+		float startTime;
+		float endTime;
+	};
 
-		const std::string& GetName() const { return name; }
+	template<typename T>
+	struct FieldStore
+	{
+		static const bool DIRECT = true;
 
-		virtual void ActivateAnimation() = 0;
-		virtual void ActivateAnimation(AnimationClip& clip) = 0;
-		virtual void DeactivateAnimation() = 0;
-		virtual bool AnimationActivated() const = 0;
-		virtual std::shared_ptr<AnimationClip> GetAnimation() = 0;
-		virtual void Update(float time) = 0;
+		static void Store(void* target, const T& value) { *static_cast<T*>(target) = value; }
 	};
 
-	template<typename T, typename TClip>
-	class TypedProperty : public Property
+	template<typename T, typename TOwner, void (TOwner::*Setter)(T)>
+	struct MemberStore
+	{
+		static const bool DIRECT = false;
+
+		static void Store(void* target, const T& value) { (static_cast<TOwner*>(target)->*Setter)(value); }
+	};
+
+	template<typename T, typename TClip, typename TStore>
+	class PropertyBinder
 	{
 		static_assert(
 			std::is_base_of<TypedAnimationClip<T>, TClip>::value,
@@ -50,46 +101,66 @@ private:
 		);
 
 	private:
-		T* field = nullptr;
-		std::function<void(T value)> setter;
-		std::shared_ptr<TClip> clip;
-		T defaultValue;
+		typedef BezierTraits<T> Traits;
+
+		static_assert(Traits::COMPONENTS <= MAX_COMPONENTS, "Too many components in property value");
+
+		static T GetDefaultValue(const Property& animatorProperty);
+		static std::shared_ptr<AnimationClip> CreateClip(const Property& animatorProperty, ClipType type);
+		static std::shared_ptr<AnimationClip> CopyClip(AnimationClip& clip);
+		static void Update(Property& animatorProperty, float time);
+		static ChannelBinding BindChannels(Property& animatorProperty, ChannelEvaluator& evaluator, bool baked);
+		static void CommitChannels(Property& animatorProperty, const ChannelEvaluator& evaluator);
 	public:
-		TypedProperty(const std::string& name, T* field, T defaultValue)
-			: Property(name), field(field), defaultValue(defaultValue) { }
-
-		TypedProperty(const std::string& name, std::function<void(T value)> setter, T defaultValue)
-			: Property(name), setter(setter), defaultValue(defaultValue) { }
-
-		void ActivateAnimation() override;
-		void ActivateAnimation(AnimationClip& clip) override;
-		void DeactivateAnimation() override;
-		bool AnimationActivated() const override;
-		std::shared_ptr<AnimationClip> GetAnimation() override;
-		void Update(float time) override;
+		static const PropertyOperations OPERATIONS;
+
+		static Property CreateProperty(const std::string& name, void* target, const T& defaultValue);
 	};
 
-	std::vector<std::shared_ptr<Property>> properties;
-	std::vector<std::shared_ptr<Property>> animatedProperties;
+	std::vector<Property> properties;
+	std::vector<PropertyId> animatedProperties;
+	std::unordered_map<std::string, PropertyId> propertyIds;
+	std::vector<bool> drivenProperties;
+
+	ChannelEvaluator evaluator;
+	std::vector<std::pair<const AnimationClip*, size_t>> boundClips;
+	std::vector<PropertyId> committedProperties;
+	std::vector<PropertyId> scalarProperties;
+	bool channelsDirty = true;
+	bool boundBaked = false;
+	float channelsStartTime = 0.0f;
+	float channelsEndTime = 0.0f;
+	// Time the driven values were last written for, valid while evaluated is set
+	float evaluatedTime = 0.0f;
+	bool evaluated = false;
 	float animationTime;
 	float currentTime = 0.0f;
 	Mode mode;
 	float timeScale = 1.0f;
+
+	PropertyId AddProperty(Property&& animatorProperty);
+	bool ChannelsOutdated() const;
+	void BindChannels();
+
+	static bool Settled(float from, float to, float startTime, float endTime);
 public:
 	bool Enabled = false;
 	bool Paused = false;
+	bool Baked = false;
 
 	template<typename T, typename TClip>
-	void RegisterProperty(const std::string name, T* field, T defaultValue = T());
+	PropertyId RegisterProperty(const std::string name, T* field, T defaultValue = T());
 
-	template<typename T, typename TClip>
-	void RegisterProperty(
-		const std::string name,
-		std::function<void(T value)> setter,
-		T defaultValue = T()
-	);
+	// Binds a setter of the owner object, e.g.
+	// RegisterProperty<int, ParameterAnimationClip, Scene, &Scene::SetN>(name, this)
+	template<typename T, typename TClip, typename TOwner, void (TOwner::*Setter)(T)>
+	PropertyId RegisterProperty(const std::string name, TOwner* owner, T defaultValue = T());
+
+	PropertyId GetPropertyId(const std::string& name) const;
 
-	void ActivatePropertyAnimation(const std::string& name);
+	void ActivatePropertyAnimation(PropertyId id, ClipType type = ClipType::Curve);
+	void ActivatePropertyAnimation(const std::string& name, ClipType type = ClipType::Curve);
+	void DeactivatePropertyAnimation(PropertyId id);
 	void DeactivatePropertyAnimation(const std::string& name);
 
 	size_t GetAnimatedPropertiesCount() { return animatedProperties.size(); };
@@ -106,11 +177,14 @@ public:
 	Mode GetAnimationMode() const { return mode; }
 	void SetAnimationMode(Animator::Mode mode);
 
-	const std::string& GetPropertyName(int index) { return properties[index]->GetName(); }
+	const std::string& GetPropertyName(int index) { return properties[index].name; }
 
-	bool IsAnimatedProperty(int index) { return properties[index]->AnimationActivated(); }
+	bool IsAnimatedProperty(int index) { return drivenProperties[index]; }
 
-	bool IsDriven(const std::string& propertyName) const;
+	PropertyId GetAnimatedPropertyId(size_t index) const { return animatedProperties[index]; }
+
+	bool IsDriven(PropertyId id) const { return Enabled && id < drivenProperties.size() && drivenProperties[id]; }
+	bool IsDriven(const std::string& propertyName) const { return IsDriven(GetPropertyId(propertyName)); }
 
 	std::shared_ptr<AnimationClip> GetPropertyAnimation(size_t index);
 
@@ -121,71 +195,172 @@ public:
 	void Load(Archive& archive);
 };
 
-template<typename T, typename TClip>
-void Animator::TypedProperty<T, TClip>::ActivateAnimation()
+template<typename T, typename TClip, typename TStore>
+const Animator::PropertyOperations Animator::PropertyBinder<T, TClip, TStore>::OPERATIONS = {
+	&PropertyBinder<T, TClip, TStore>::CreateClip,
+	&PropertyBinder<T, TClip, TStore>::CopyClip,
+	&PropertyBinder<T, TClip, TStore>::Update,
+	&PropertyBinder<T, TClip, TStore>::BindChannels,
+	&PropertyBinder<T, TClip, TStore>::CommitChannels
+};
+
+template<typename T, typename TClip, typename TStore>
+Animator::Property Animator::PropertyBinder<T, TClip, TStore>::CreateProperty(
+	const std::string& name,
+	void* target,
+	const T& defaultValue
+)
 {
-	DeactivateAnimation();
-	clip = std::shared_ptr<TClip>(new TClip(GetName(), defaultValue));
+	Property animatorProperty;
+	animatorProperty.name = name;
+	animatorProperty.target = target;
+	animatorProperty.operations = &OPERATIONS;
+	const typename Traits::Value value = Traits::ToValue(defaultValue);
+	for (int i = 0; i < Traits::COMPONENTS; i++)
+	{
+		animatorProperty.defaultValue[i] = Traits::Component(value, i);
+	}
+
+	return animatorProperty;
 }
 
-template<typename T, typename TClip>
-void Animator::TypedProperty<T, TClip>::ActivateAnimation(AnimationClip& clip)
+template<typename T, typename TClip, typename TStore>
+T Animator::PropertyBinder<T, TClip, TStore>::GetDefaultValue(const Property& animatorProperty)
 {
-	TClip& typedClip = dynamic_cast<TClip&>(clip);
-	DeactivateAnimation();
-	this->clip = std::shared_ptr<TClip>(new TClip(typedClip));
+	typename Traits::Value value;
+	for (int i = 0; i < Traits::COMPONENTS; i++)
+	{
+		Traits::Component(value, i) = animatorProperty.defaultValue[i];
+	}
+
+	return Traits::FromValue(value);
 }
 
-template<typename T, typename TClip>
-void Animator::TypedProperty<T, TClip>::DeactivateAnimation()
+template<typename T, typename TClip, typename TStore>
+std::shared_ptr<AnimationClip> Animator::PropertyBinder<T, TClip, TStore>::CreateClip(
+	const Property& animatorProperty,
+	ClipType type
+)
 {
-	clip = nullptr;
+	const T defaultValue = GetDefaultValue(animatorProperty);
+	switch (type)
+	{
+	case ClipType::Keyframes:
+		return std::shared_ptr<AnimationClip>(new KeyframeTrack<TClip>(animatorProperty.name, defaultValue));
+	default:
+		return std::shared_ptr<AnimationClip>(new TClip(animatorProperty.name, defaultValue));
+	}
 }
 
-template<typename T, typename TClip>
-bool Animator::TypedProperty<T, TClip>::AnimationActivated() const
+template<typename T, typename TClip, typename TStore>
+std::shared_ptr<AnimationClip> Animator::PropertyBinder<T, TClip, TStore>::CopyClip(AnimationClip& clip)
+{
+	KeyframeTrack<TClip>* track = dynamic_cast<KeyframeTrack<TClip>*>(&clip);
+	if (track != nullptr)
+	{
+		return std::shared_ptr<AnimationClip>(new KeyframeTrack<TClip>(*track));
+	}
+
+	TClip& typedClip = dynamic_cast<TClip&>(clip);
+	return std::shared_ptr<AnimationClip>(new TClip(typedClip));
+}
+
+template<typename T, typename TClip, typename TStore>
+void Animator::PropertyBinder<T, TClip, TStore>::Update(Property& animatorProperty, float time)
 {
-	return clip != nullptr;
+	ValueAnimationClip<T>* clip = static_cast<ValueAnimationClip<T>*>(animatorProperty.clip.get());
+	TStore::Store(animatorProperty.target, clip->Evaluate(time));
 }
 
-template<typename T, typename TClip>
-void Animator::RegisterProperty(const std::string name, T* field, T defaultValue)
+template<typename T, typename TClip, typename TStore>
+Animator::ChannelBinding Animator::PropertyBinder<T, TClip, TStore>::BindChannels(
+	Property& animatorProperty,
+	ChannelEvaluator& evaluator,
+	bool baked
+)
 {
-	std::shared_ptr<Property> animatorProperty;
-	animatorProperty = std::shared_ptr<Property>(new TypedProperty<T, TClip>(name, field, defaultValue));
-	properties.push_back(animatorProperty);
+	const ValueAnimationClip<T>* clip = static_cast<const ValueAnimationClip<T>*>(animatorProperty.clip.get());
+	animatorProperty.startTime = clip->GetStartTime();
+	animatorProperty.endTime = clip->GetEndTime();
+
+	// Keyframe tracks are evaluated per property through their cursor
+	TypedAnimationClip<T>* curveClip = dynamic_cast<TypedAnimationClip<T>*>(animatorProperty.clip.get());
+	if (curveClip == nullptr)
+	{
+		return ChannelBinding::None;
+	}
+
+	const BezierCurve<T>& curve = curveClip->GetCurve();
+	if (!baked && !curve.HasCoefficients())
+	{
+		return ChannelBinding::None;
+	}
+
+	// Fields whose components are floats are written directly by the evaluator
+	const bool direct = TStore::DIRECT && std::is_same<typename Traits::Value, T>::value;
+	float* target = direct ? static_cast<float*>(animatorProperty.target) : nullptr;
+	ChannelEvaluator::Channel* channels = animatorProperty.channels;
+	if (baked)
+	{
+		const BakedCurve<T>& table = curveClip->GetBakedCurve();
+		for (int i = 0; i < Traits::COMPONENTS; i++)
+		{
+			channels[i] = evaluator.AddBakedChannel(
+				table.GetSamples() + i,
+				Traits::COMPONENTS,
+				table.GetSamplesCount(),
+				table.GetStartTime(),
+				table.GetInverseStep(),
+				direct ? target + i : nullptr
+			);
+		}
+	}
+	else
+	{
+		const float* coefficients = reinterpret_cast<const float*>(curve.GetCoefficients());
+		for (int i = 0; i < Traits::COMPONENTS; i++)
+		{
+			channels[i] = evaluator.AddChannel(
+				coefficients + i,
+				Traits::COMPONENTS,
+				curve.GetDegree(),
+				curveClip->GetStartTime(),
+				curveClip->GetEndTime(),
+				direct ? target + i : nullptr
+			);
+		}
+	}
+
+	return direct ? ChannelBinding::Fields : ChannelBinding::Committed;
 }
 
-template<typename T, typename TClip>
-void Animator::RegisterProperty(
-	const std::string name,
-	std::function<void(T value)> setter,
-	T defaultValue
+template<typename T, typename TClip, typename TStore>
+void Animator::PropertyBinder<T, TClip, TStore>::CommitChannels(
+	Property& animatorProperty,
+	const ChannelEvaluator& evaluator
 )
 {
-	std::shared_ptr<Property> animatorProperty;
-	animatorProperty = std::shared_ptr<Property>(new TypedProperty<T, TClip>(name, setter, defaultValue));
-	properties.push_back(animatorProperty);
+	typename Traits::Value value;
+	for (int i = 0; i < Traits::COMPONENTS; i++)
+	{
+		Traits::Component(value, i) = evaluator.GetResult(animatorProperty.channels[i]);
+	}
+
+	TStore::Store(animatorProperty.target, Traits::FromValue(value));
 }
 
 template<typename T, typename TClip>
-std::shared_ptr<AnimationClip> Animator::TypedProperty<T, TClip>::GetAnimation()
+Animator::PropertyId Animator::RegisterProperty(const std::string name, T* field, T defaultValue)
 {
-	return clip;
+	typedef PropertyBinder<T, TClip, FieldStore<T>> Binder;
+	return AddProperty(Binder::CreateProperty(name, field, defaultValue));
 }
 
-template<typename T, typename TClip>
-void Animator::TypedProperty<T, TClip>::Update(float time)
+template<typename T, typename TClip, typename TOwner, void (TOwner::*Setter)(T)>
+Animator::PropertyId Animator::RegisterProperty(const std::string name, TOwner* owner, T defaultValue)
 {
-	T value = clip->Evaluate(time);
-	if (field == nullptr)
-	{
-		setter(value);
-	}
-	else
-	{
-		*field = value;
-	}
+	typedef PropertyBinder<T, TClip, MemberStore<T, TOwner, Setter>> Binder;
+	return AddProperty(Binder::CreateProperty(name, owner, defaultValue));
 }
 
 template<class Archive>
@@ -193,6 +368,7 @@ void Animator::Save(Archive& archive) const
 {
 	archive(CEREAL_NVP(Enabled));
 	archive(CEREAL_NVP(Paused));
+	archive(CEREAL_NVP(Baked));
 	archive(CEREAL_NVP_("AnimationTime", animationTime));
 	archive(CEREAL_NVP_("CurrentTime", currentTime));
 	archive(CEREAL_NVP_("AnimationMode", mode));
@@ -200,7 +376,7 @@ void Animator::Save(Archive& archive) const
 	std::vector<std::shared_ptr<AnimationClip>> clips;
 	for (size_t i = 0; i < animatedProperties.size(); i++)
 	{
-		clips.push_back(animatedProperties[i]->GetAnimation());
+		clips.push_back(properties[animatedProperties[i]].clip);
 	}
 
 	archive(CEREAL_NVP_("AnimationClips", clips));
@@ -211,6 +387,7 @@ void Animator::Load(Archive& archive)
 {
 	archive(CEREAL_NVP(Enabled));
 	archive(CEREAL_NVP(Paused));
+	LoadOptionalNVP(archive, "Baked", Baked);
 	archive(CEREAL_NVP_("AnimationTime", animationTime));
 	archive(CEREAL_NVP_("CurrentTime", currentTime));
 	archive(CEREAL_NVP_("AnimationMode", mode));
@@ -244,47 +421,41 @@ void Animator::Load(Archive& archive)
 	for (size_t i = 0; i < clips.size(); i++)
 	{
 		std::shared_ptr<AnimationClip> clip = clips[i];
-		bool used = false;
-		for (size_t j = 0; j < properties.size(); j++)
+		PropertyId id = GetPropertyId(clip->GetPropertyName());
+		if (id == INVALID_PROPERTY_ID)
 		{
-			std::shared_ptr<Property> animatorProperty = properties[j];
-			if (animatorProperty->GetName() == clip->GetPropertyName())
-			{
-				if (animatorProperty->AnimationActivated())
-				{
-					Debug::LogFormat(
-						Debug::MessageType::Warning,
-						"Animation for property \"%s\" already exists",
-						animatorProperty->GetName().c_str()
-					);
-					break;
-				}
-
-				try
-				{
-					used = true;
-					animatorProperty->ActivateAnimation(*clip);
-					animatedProperties.push_back(animatorProperty);
-				}
-				catch (const std::bad_cast&)
-				{
-					Debug::LogFormat(
-						Debug::MessageType::Warning,
-						"Wrong type for property animation - \"%s\". The animation will be deleted when the scene is saved",
-						animatorProperty->GetName().c_str()
-					);
-				}
-
-				break;
-			}
+			Debug::LogFormat(
+				Debug::MessageType::Warning,
+				"No property with name - \"%s\". The animation will be deleted when the scene is saved",
+				clip->GetPropertyName().c_str()
+			);
+			continue;
 		}
 
-		if (!used)
+		Property& animatorProperty = properties[id];
+		if (drivenProperties[id])
 		{
 			Debug::LogFormat(
 				Debug::MessageType::Warning,
-				"No property with name - \"%s\". The animation will be deleted when the scene is saved",
-				clip->GetPropertyName().c_str()
+				"Animation for property \"%s\" already exists",
+				animatorProperty.name.c_str()
+			);
+			continue;
+		}
+
+		try
+		{
+			animatorProperty.clip = animatorProperty.operations->CopyClip(*clip);
+			animatedProperties.push_back(id);
+			drivenProperties[id] = true;
+			channelsDirty = true;
+		}
+		catch (const std::bad_cast&)
+		{
+			Debug::LogFormat(
+				Debug::MessageType::Warning,
+				"Wrong type for property animation - \"%s\". The animation will be deleted when the scene is saved",
+				animatorProperty.name.c_str()
 			);
 		}
 	}
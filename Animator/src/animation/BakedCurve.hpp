@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "BezierCurve.hpp"
+
+// Curve resampled into a uniform table over [startTime; endTime].
+// Playback is an index and a lerp, without any curve math.
+template<typename T>
+class BakedCurve
+{
+public:
+	typedef BezierTraits<T> Traits;
+	typedef typename Traits::Value Value;
+
+	static const size_t MAX_SAMPLES_COUNT = 1 << 16;
+private:
+	std::vector<Value> samples;
+	float startTime = 0.0f;
+	float inverseStep = 0.0f;
+	float rate = 0.0f;
+	float error = 0.0f;
+
+	void Resample(const BezierCurve<T>& curve, size_t count);
+	float MeasureError(const BezierCurve<T>& curve) const;
+public:
+	void Bake(const BezierCurve<T>& curve, float startTime, float endTime, float rate, float tolerance);
+
+	const float* GetSamples() const { return reinterpret_cast<const float*>(&samples[0]); }
+	size_t GetSamplesCount() const { return samples.size(); }
+	size_t GetMemorySize() const { return samples.size() * sizeof(Value); }
+
+	float GetStartTime() const { return startTime; }
+	float GetInverseStep() const { return inverseStep; }
+	float GetRate() const { return rate; }
+	float GetError() const { return error; }
+
+	Value EvaluateValue(float time) const;
+	T Evaluate(float time) const { return Traits::FromValue(EvaluateValue(time)); }
+};
+
+template<typename T>
+void BakedCurve<T>::Resample(const BezierCurve<T>& curve, size_t count)
+{
+	std::vector<float> parameters(count, 0.0f);
+	const float step = count == 1 ? 0.0f : 1.0f / (count - 1);
+	for (size_t i = 0; i < count; i++)
+	{
+		parameters[i] = std::min(step * i, 1.0f);
+	}
+
+	samples.resize(count);
+	curve.EvaluateValues(&parameters[0], &samples[0], count);
+}
+
+template<typename T>
+float BakedCurve<T>::MeasureError(const BezierCurve<T>& curve) const
+{
+	// Midpoints between samples are where a lerp strays the most
+	const size_t count = samples.size() - 1;
+	const float step = 1.0f / count;
+	std::vector<float> parameters(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		parameters[i] = step * (i + 0.5f);
+	}
+
+	std::vector<Value> expected(count);
+	curve.EvaluateValues(&parameters[0], &expected[0], count);
+
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const Value actual = 0.5f * (samples[i] + samples[i + 1]);
+		for (int component = 0; component < Traits::COMPONENTS; component++)
+		{
+			const float difference = Traits::Component(expected[i], component) - Traits::Component(actual, component);
+			maxError = std::max(maxError, std::fabs(difference));
+		}
+	}
+
+	return maxError;
+}
+
+template<typename T>
+void BakedCurve<T>::Bake(const BezierCurve<T>& curve, float startTime, float endTime, float rate, float tolerance)
+{
+	this->startTime = startTime;
+	this->rate = rate;
+	const float duration = endTime - startTime;
+	if (duration <= 0.0f || rate <= 0.0f)
+	{
+		Resample(curve, 1);
+		inverseStep = 0.0f;
+		error = 0.0f;
+		return;
+	}
+
+	// Doubles the rate until the table reproduces the curve within tolerance
+	while (true)
+	{
+		size_t count = (size_t)std::ceil(duration * this->rate) + 1;
+		count = std::min(std::max(count, (size_t)2), MAX_SAMPLES_COUNT);
+		Resample(curve, count);
+		error = MeasureError(curve);
+		if (error <= tolerance || count == MAX_SAMPLES_COUNT)
+		{
+			inverseStep = (count - 1) / duration;
+			this->rate = inverseStep;
+			return;
+		}
+
+		this->rate *= 2.0f;
+	}
+}
+
+template<typename T>
+typename BakedCurve<T>::Value BakedCurve<T>::EvaluateValue(float time) const
+{
+	if (samples.size() < 2)
+	{
+		return samples.empty() ? Value() : samples[0];
+	}
+
+	const float last = float(samples.size() - 1);
+	const float position = std::min(std::max((time - startTime) * inverseStep, 0.0f), last);
+	const size_t index = std::min((size_t)position, samples.size() - 2);
+	const float fraction = position - index;
+	return samples[index] + fraction * (samples[index + 1] - samples[index]);
+}
@@ -0,0 +1,70 @@
+#include "BezierBatch.hpp"
+
+#include <algorithm>
+
+#include "BezierCurve.hpp"
+#include "Lanes.hpp"
+
+void BezierBatch::Evaluate(
+	const float* coefficients,
+	size_t components,
+	size_t degree,
+	const float* parameters,
+	float* results,
+	size_t count
+)
+{
+	Lanes weights[BezierCurve<float>::MAX_FAST_DEGREE + 1];
+	float padded[LANES_COUNT];
+	float lanes[LANES_COUNT];
+
+	const Lanes one = LANES_SET1(1.0f);
+	for (size_t start = 0; start < count; start += LANES_COUNT)
+	{
+		// The tail is evaluated on a padded copy of the remaining parameters
+		const size_t active = std::min(LANES_COUNT, count - start);
+		Lanes t;
+		if (active == LANES_COUNT)
+		{
+			t = LANES_LOAD(parameters + start);
+		}
+		else
+		{
+			std::fill(padded, padded + LANES_COUNT, 0.0f);
+			std::copy(parameters + start, parameters + count, padded);
+			t = LANES_LOAD(padded);
+		}
+
+		// Weight of the i-th term is t^i * s^(n - i)
+		const Lanes s = LANES_SUB(one, t);
+		weights[degree] = one;
+		for (size_t i = degree; i-- > 0;)
+		{
+			weights[i] = LANES_MUL(weights[i + 1], s);
+		}
+
+		Lanes tPower = t;
+		for (size_t i = 1; i <= degree; i++)
+		{
+			weights[i] = LANES_MUL(weights[i], tPower);
+			tPower = LANES_MUL(tPower, t);
+		}
+
+		for (size_t component = 0; component < components; component++)
+		{
+			Lanes result = LANES_SET1(0.0f);
+			const float* coefficient = coefficients + component;
+			for (size_t i = 0; i <= degree; i++, coefficient += components)
+			{
+				result = LANES_ADD(result, LANES_MUL(LANES_SET1(*coefficient), weights[i]));
+			}
+
+			LANES_STORE(lanes, result);
+			float* target = results + start * components + component;
+			for (size_t lane = 0; lane < active; lane++, target += components)
+			{
+				*target = lanes[lane];
+			}
+		}
+	}
+}
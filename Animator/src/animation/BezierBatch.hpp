@@ -0,0 +1,17 @@
+#pragma once
+
+// Evaluates a Bernstein polynomial at many parameters at once, SIMD lanes
+// running over the parameters. Coefficients and results are interleaved by
+// components, parameters are expected to be within [0; 1].
+class BezierBatch
+{
+public:
+	static void Evaluate(
+		const float* coefficients,
+		size_t components,
+		size_t degree,
+		const float* parameters,
+		float* results,
+		size_t count
+	);
+};
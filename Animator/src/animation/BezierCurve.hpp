@@ -0,0 +1,239 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <glm/glm.hpp>
+
+#include "BezierBatch.hpp"
+
+// Describes how a clip value type is evaluated: the value type used for the
+// curve arithmetic, its float component count and conversions to and from it.
+template<typename T>
+struct BezierTraits;
+
+template<>
+struct BezierTraits<float>
+{
+	typedef float Value;
+	static const int COMPONENTS = 1;
+
+	static Value ToValue(float value) { return value; }
+	static float FromValue(Value value) { return value; }
+	static float& Component(Value& value, int index) { return value; }
+	static float Component(const Value& value, int index) { return value; }
+};
+
+template<>
+struct BezierTraits<int>
+{
+	typedef float Value;
+	static const int COMPONENTS = 1;
+
+	static Value ToValue(int value) { return (float)value; }
+
+	static int FromValue(Value value)
+	{
+		// Values that are an integer up to float noise are snapped, everything
+		// else is truncated like the cast in the original De Casteljau loop
+		const float rounded = std::round(value);
+		return std::fabs(value - rounded) < 1e-3f ? (int)rounded : (int)value;
+	}
+
+	static float& Component(Value& value, int index) { return value; }
+	static float Component(const Value& value, int index) { return value; }
+};
+
+template<>
+struct BezierTraits<glm::vec3>
+{
+	typedef glm::vec3 Value;
+	static const int COMPONENTS = 3;
+
+	static Value ToValue(const glm::vec3& value) { return value; }
+	static glm::vec3 FromValue(const Value& value) { return value; }
+	static float& Component(Value& value, int index) { return value[index]; }
+	static float Component(const Value& value, int index) { return value[index]; }
+};
+
+template<>
+struct BezierTraits<glm::vec4>
+{
+	typedef glm::vec4 Value;
+	static const int COMPONENTS = 4;
+
+	static Value ToValue(const glm::vec4& value) { return value; }
+	static glm::vec4 FromValue(const Value& value) { return value; }
+	static float& Component(Value& value, int index) { return value[index]; }
+	static float Component(const Value& value, int index) { return value[index]; }
+};
+
+// Bezier curve over a set of control points. Bernstein coefficients
+// (binomial * point) are computed once in SetPoints, so evaluation is O(n)
+// and never allocates. Curves with 2-4 points use unrolled kernels.
+//
+// Results agree with the plain De Casteljau evaluation to within
+// 1e-6 * pointsCount * max|point| per component. Integer curves are
+// evaluated in float and converted once; the old per-level truncation
+// could undershoot that result by up to pointsCount - 2.
+template<typename T>
+class BezierCurve
+{
+public:
+	typedef BezierTraits<T> Traits;
+	typedef typename Traits::Value Value;
+
+	// Above this degree binomial coefficients no longer fit comfortably in
+	// float, so the curve falls back to De Casteljau over a reused buffer
+	static const size_t MAX_FAST_DEGREE = 64;
+private:
+	size_t degree = 0;
+	std::vector<Value> points;
+	std::vector<Value> coefficients;
+	mutable std::vector<Value> scratch;
+
+	Value EvaluateHorner(float t) const;
+	Value EvaluateDeCasteljau(float t) const;
+public:
+	void SetPoints(const std::vector<T>& states);
+
+	size_t GetDegree() const { return degree; }
+	size_t GetPointsCount() const { return points.size(); }
+
+	bool HasCoefficients() const { return !coefficients.empty(); }
+	const Value* GetCoefficients() const { return &coefficients[0]; }
+
+	Value EvaluateValue(float t) const;
+	T Evaluate(float t) const { return Traits::FromValue(EvaluateValue(t)); }
+
+	void EvaluateValues(const float* parameters, Value* results, size_t count) const;
+};
+
+template<typename T>
+void BezierCurve<T>::SetPoints(const std::vector<T>& states)
+{
+	points.resize(states.size());
+	for (size_t i = 0; i < states.size(); i++)
+	{
+		points[i] = Traits::ToValue(states[i]);
+	}
+
+	degree = points.empty() ? 0 : points.size() - 1;
+	coefficients.clear();
+	if (points.empty() || degree > MAX_FAST_DEGREE)
+	{
+		scratch.resize(points.size());
+		return;
+	}
+
+	coefficients.resize(points.size());
+	float binomial = 1.0f;
+	for (size_t i = 0; i <= degree; i++)
+	{
+		coefficients[i] = binomial * points[i];
+		binomial = binomial * float(degree - i) / float(i + 1);
+	}
+}
+
+template<typename T>
+typename BezierCurve<T>::Value BezierCurve<T>::EvaluateValue(float t) const
+{
+	if (points.empty())
+	{
+		return Value();
+	}
+
+	if (coefficients.empty())
+	{
+		return EvaluateDeCasteljau(t);
+	}
+
+	const Value* c = &coefficients[0];
+	const float s = 1.0f - t;
+	switch (degree)
+	{
+	case 0:
+		return c[0];
+	case 1:
+		return s * c[0] + t * c[1];
+	case 2:
+		return (s * s) * c[0] + (s * t) * c[1] + (t * t) * c[2];
+	case 3:
+		return (s * s * s) * c[0] + (s * s * t) * c[1] + (s * t * t) * c[2] + (t * t * t) * c[3];
+	default:
+		return EvaluateHorner(t);
+	}
+}
+
+template<typename T>
+void BezierCurve<T>::EvaluateValues(const float* parameters, Value* results, size_t count) const
+{
+	if (coefficients.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			results[i] = EvaluateValue(parameters[i]);
+		}
+		return;
+	}
+
+	BezierBatch::Evaluate(
+		reinterpret_cast<const float*>(&coefficients[0]),
+		Traits::COMPONENTS,
+		degree,
+		parameters,
+		reinterpret_cast<float*>(results),
+		count
+	);
+}
+
+template<typename T>
+typename BezierCurve<T>::Value BezierCurve<T>::EvaluateHorner(float t) const
+{
+	// Sum c[i] * t^i * s^(n - i) evaluated as a polynomial in t / s or s / t,
+	// whichever ratio does not exceed one
+	const Value* c = &coefficients[0];
+	const float s = 1.0f - t;
+	float power = 1.0f;
+	Value result;
+	if (t <= 0.5f)
+	{
+		const float u = t / s;
+		result = c[degree];
+		for (size_t i = degree; i-- > 0;)
+		{
+			result = result * u + c[i];
+			power *= s;
+		}
+	}
+	else
+	{
+		const float v = s / t;
+		result = c[0];
+		for (size_t i = 1; i <= degree; i++)
+		{
+			result = result * v + c[i];
+			power *= t;
+		}
+	}
+
+	return result * power;
+}
+
+template<typename T>
+typename BezierCurve<T>::Value BezierCurve<T>::EvaluateDeCasteljau(float t) const
+{
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		scratch[i] = points[i];
+	}
+
+	for (size_t limit = points.size(); limit > 1; limit--)
+	{
+		for (size_t i = 0; i < limit - 1; i++)
+		{
+			scratch[i] = (1 - t) * scratch[i] + t * scratch[i + 1];
+		}
+	}
+
+	return scratch[0];
+}
@@ -0,0 +1,193 @@
+#include "ChannelEvaluator.hpp"
+
+#include <algorithm>
+
+#include "BezierCurve.hpp"
+#include "Lanes.hpp"
+
+// Groups are padded to LANES, the kernel steps by the register width
+static_assert(ChannelEvaluator::LANES == LANES_COUNT, "ChannelEvaluator::LANES must match the width of Lanes");
+
+void ChannelEvaluator::Group::Reserve(size_t lanes)
+{
+	if (lanes <= stride)
+	{
+		return;
+	}
+
+	size_t newStride = stride == 0 ? LANES : stride;
+	while (newStride < lanes)
+	{
+		newStride *= 2;
+	}
+
+	std::vector<float> newCoefficients((degree + 1) * newStride, 0.0f);
+	for (size_t row = 0; row <= degree; row++)
+	{
+		for (size_t lane = 0; lane < count; lane++)
+		{
+			newCoefficients[row * newStride + lane] = coefficients[row * stride + lane];
+		}
+	}
+
+	coefficients.swap(newCoefficients);
+	startTimes.resize(newStride, 0.0f);
+	inverseDurations.resize(newStride, 0.0f);
+	results.resize(newStride, 0.0f);
+	stride = newStride;
+}
+
+void ChannelEvaluator::Clear()
+{
+	groups.clear();
+	bakedChannels.clear();
+	channelsCount = 0;
+}
+
+ChannelEvaluator::Channel ChannelEvaluator::AddChannel(
+	const float* coefficients,
+	size_t coefficientsStride,
+	size_t degree,
+	float startTime,
+	float endTime,
+	float* target
+)
+{
+	size_t groupIndex = 0;
+	while (groupIndex < groups.size() && groups[groupIndex].degree != degree)
+	{
+		groupIndex++;
+	}
+
+	if (groupIndex == groups.size())
+	{
+		groups.push_back(Group());
+		groups.back().degree = degree;
+	}
+
+	Group& group = groups[groupIndex];
+	group.Reserve(group.count + 1);
+
+	const size_t lane = group.count++;
+	for (size_t row = 0; row <= degree; row++)
+	{
+		group.coefficients[row * group.stride + lane] = coefficients[row * coefficientsStride];
+	}
+
+	const float duration = endTime - startTime;
+	group.startTimes[lane] = startTime;
+	group.inverseDurations[lane] = duration == 0.0f ? 0.0f : 1.0f / duration;
+	group.targets.push_back(target);
+	channelsCount++;
+
+	return Channel{ groupIndex, lane };
+}
+
+ChannelEvaluator::Channel ChannelEvaluator::AddBakedChannel(
+	const float* samples,
+	size_t samplesStride,
+	size_t samplesCount,
+	float startTime,
+	float inverseStep,
+	float* target
+)
+{
+	BakedChannel channel;
+	channel.samples = samples;
+	channel.stride = samplesStride;
+	channel.count = samplesCount;
+	channel.startTime = startTime;
+	channel.inverseStep = inverseStep;
+	channel.target = target;
+	channel.result = samples[0];
+	bakedChannels.push_back(channel);
+	channelsCount++;
+
+	return Channel{ BAKED_GROUP, bakedChannels.size() - 1 };
+}
+
+void ChannelEvaluator::EvaluateGroup(Group& group, float time)
+{
+	Lanes powers[BezierCurve<float>::MAX_FAST_DEGREE + 1];
+
+	const size_t degree = group.degree;
+	const Lanes zero = LANES_SET1(0.0f);
+	const Lanes one = LANES_SET1(1.0f);
+	const Lanes times = LANES_SET1(time);
+	for (size_t lane = 0; lane < group.count; lane += LANES)
+	{
+		Lanes t = LANES_MUL(
+			LANES_SUB(times, LANES_LOAD(&group.startTimes[lane])),
+			LANES_LOAD(&group.inverseDurations[lane])
+		);
+		t = LANES_MIN(LANES_MAX(t, zero), one);
+		const Lanes s = LANES_SUB(one, t);
+
+		powers[0] = one;
+		for (size_t i = 1; i <= degree; i++)
+		{
+			powers[i] = LANES_MUL(powers[i - 1], s);
+		}
+
+		// Sum of coefficient * t^i * s^(n - i), all weights stay within [0; 1]
+		Lanes tPower = one;
+		Lanes result = zero;
+		const float* row = &group.coefficients[lane];
+		for (size_t i = 0; i <= degree; i++, row += group.stride)
+		{
+			const Lanes weight = LANES_MUL(tPower, powers[degree - i]);
+			result = LANES_ADD(result, LANES_MUL(LANES_LOAD(row), weight));
+			tPower = LANES_MUL(tPower, t);
+		}
+
+		LANES_STORE(&group.results[lane], result);
+	}
+}
+
+void ChannelEvaluator::Evaluate(float time)
+{
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		EvaluateGroup(groups[i], time);
+	}
+
+	for (size_t i = 0; i < bakedChannels.size(); i++)
+	{
+		BakedChannel& channel = bakedChannels[i];
+		if (channel.count < 2)
+		{
+			continue;
+		}
+
+		const float last = float(channel.count - 1);
+		const float position = std::min(std::max((time - channel.startTime) * channel.inverseStep, 0.0f), last);
+		const size_t index = std::min((size_t)position, channel.count - 2);
+		const float from = channel.samples[index * channel.stride];
+		const float to = channel.samples[(index + 1) * channel.stride];
+		channel.result = from + (position - index) * (to - from);
+	}
+}
+
+void ChannelEvaluator::Scatter() const
+{
+	for (size_t i = 0; i < groups.size(); i++)
+	{
+		const Group& group = groups[i];
+		for (size_t lane = 0; lane < group.count; lane++)
+		{
+			float* target = group.targets[lane];
+			if (target != nullptr)
+			{
+				*target = group.results[lane];
+			}
+		}
+	}
+
+	for (size_t i = 0; i < bakedChannels.size(); i++)
+	{
+		if (bakedChannels[i].target != nullptr)
+		{
+			*bakedChannels[i].target = bakedChannels[i].result;
+		}
+	}
+}
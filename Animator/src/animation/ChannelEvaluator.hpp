@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Evaluates float channels of Bezier clips in structure-of-arrays batches.
+// Channels are grouped by degree; each group keeps one row of coefficients
+// per Bernstein term, so a single SIMD pass evaluates several channels.
+// Baked channels are a single table fetch and lerp each.
+class ChannelEvaluator
+{
+public:
+	struct Channel
+	{
+		size_t group;
+		size_t lane;
+	};
+
+#if defined(__AVX__)
+	static const size_t LANES = 8;
+#else
+	static const size_t LANES = 4;
+#endif
+
+	static const size_t BAKED_GROUP = SIZE_MAX;
+private:
+	struct Group
+	{
+		size_t degree = 0;
+		size_t count = 0;
+		size_t stride = 0;
+		std::vector<float> startTimes;
+		std::vector<float> inverseDurations;
+		std::vector<float> coefficients;
+		std::vector<float> results;
+		std::vector<float*> targets;
+
+		void Reserve(size_t lanes);
+	};
+
+	struct BakedChannel
+	{
+		const float* samples;
+		size_t stride;
+		size_t count;
+		float startTime;
+		float inverseStep;
+		float* target;
+		float result;
+	};
+
+	std::vector<Group> groups;
+	std::vector<BakedChannel> bakedChannels;
+	size_t channelsCount = 0;
+
+	static void EvaluateGroup(Group& group, float time);
+public:
+	void Clear();
+
+	Channel AddChannel(
+		const float* coefficients,
+		size_t coefficientsStride,
+		size_t degree,
+		float startTime,
+		float endTime,
+		float* target
+	);
+
+	Channel AddBakedChannel(
+		const float* samples,
+		size_t samplesStride,
+		size_t samplesCount,
+		float startTime,
+		float inverseStep,
+		float* target
+	);
+
+	void Evaluate(float time);
+	void Scatter() const;
+
+	float GetResult(const Channel& channel) const
+	{
+		return channel.group == BAKED_GROUP
+			? bakedChannels[channel.lane].result
+			: groups[channel.group].results[channel.lane];
+	}
+
+	size_t GetChannelsCount() const { return channelsCount; }
+};
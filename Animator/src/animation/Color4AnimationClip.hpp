@@ -12,6 +12,8 @@ public:
 
 	Color4AnimationClip() { }
 
+	static void DrawValueControl(const char* name, glm::vec4* state);
+
 	void DrawControl(const char* name, glm::vec4* state) override;
 	void DrawPreview(float t) override;
 };
@@ -10,6 +10,8 @@ public:
 
 	IntAnimationClip() { }
 
+	static void DrawValueControl(const char* name, int* state);
+
 	void DrawControl(const char* name, int* state) override;
 	void DrawPreview(float t) override;
 };
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <vector>
+#include <cfloat>
+#include <algorithm>
+#include <imgui/imgui.h>
+#include "../ConfiguredCereal.hpp"
+
+#include "ValueAnimationClip.hpp"
+#include "BezierCurve.hpp"
+
+// Interpolation of the segment that starts at a key
+enum class Interpolation
+{
+	Step,
+	Linear,
+	CatmullRom,
+	Hermite
+};
+
+// Keys with their own times, interpolated piecewise. Evaluation cost does not
+// depend on the keys count: the segment is found by a binary search, and a
+// cursor remembers the last segment so sequential playback is O(1) amortized.
+// TClip supplies the value type, the value control and the validation.
+template<typename TClip>
+class KeyframeTrack : public ValueAnimationClip<typename TClip::ValueType>
+{
+public:
+	typedef typename TClip::ValueType T;
+	typedef BezierTraits<T> Traits;
+	typedef typename Traits::Value Value;
+
+	static const char* INTERPOLATION_NAMES[];
+	static const int INTERPOLATIONS_COUNT;
+private:
+	static const int MIN_KEYS_COUNT = 2;
+	static const int PLOT_LINES_FREQUENCY = 64;
+	static const int VISIBLE_KEYS_COUNT = 8;
+
+	std::vector<float> times;
+	std::vector<T> values;
+	std::vector<Interpolation> interpolations;
+	std::vector<Value> inTangents;
+	std::vector<Value> outTangents;
+	size_t cursor = 0;
+
+	T defaultValue;
+	int selectedKey = 0;
+	float previewTime = 0.0f;
+
+	void ChangeKeysCount(int value);
+	void Validate();
+	size_t FindSegment(float time);
+	Value GetSlope(size_t key) const;
+	void DrawKeyUI(size_t key);
+	void DrawTangentControl(const char* name, Value* tangent);
+	void DrawPreview();
+public:
+	KeyframeTrack(const std::string& propertyName, T defaultValue)
+		: ValueAnimationClip<T>(propertyName), defaultValue(TClip::ValidateValue(defaultValue))
+	{
+		ChangeKeysCount(MIN_KEYS_COUNT);
+	}
+
+	KeyframeTrack() { }
+
+	size_t GetKeysCount() const { return times.size(); }
+	float GetStartTime() const override { return times.front(); }
+	float GetEndTime() const override { return times.back(); }
+
+	Value EvaluateValue(float time);
+	T Evaluate(float time) override { return Traits::FromValue(EvaluateValue(time)); }
+	void DrawUI() override final;
+
+	template<class Archive>
+	void Save(Archive& archive) const;
+
+	template<class Archive>
+	void Load(Archive& archive);
+};
+
+template<typename TClip>
+const char* KeyframeTrack<TClip>::INTERPOLATION_NAMES[] = { "Step", "Linear", "Catmull-Rom", "Hermite" };
+
+template<typename TClip>
+const int KeyframeTrack<TClip>::INTERPOLATIONS_COUNT = sizeof(KeyframeTrack<TClip>::INTERPOLATION_NAMES) / sizeof(char*);
+
+template<typename TClip>
+void KeyframeTrack<TClip>::ChangeKeysCount(int value)
+{
+	if (value < MIN_KEYS_COUNT)
+	{
+		value = MIN_KEYS_COUNT;
+	}
+
+	size_t start = times.size();
+	times.resize(value);
+	values.resize(value);
+	interpolations.resize(value, Interpolation::Linear);
+	inTangents.resize(value, Value(0.0f));
+	outTangents.resize(value, Value(0.0f));
+	for (size_t i = start; i < times.size(); i++)
+	{
+		times[i] = i == 0 ? 0.0f : times[i - 1] + 1.0f;
+		values[i] = i == 0 ? defaultValue : values[i - 1];
+	}
+
+	if (selectedKey >= value)
+	{
+		selectedKey = value - 1;
+	}
+
+	this->Invalidate();
+}
+
+template<typename TClip>
+void KeyframeTrack<TClip>::Validate()
+{
+	size_t count = times.size();
+	if (count < MIN_KEYS_COUNT)
+	{
+		times.clear();
+		count = 0;
+	}
+
+	values.resize(count, defaultValue);
+	interpolations.resize(count, Interpolation::Linear);
+	inTangents.resize(count, Value(0.0f));
+	outTangents.resize(count, Value(0.0f));
+	for (size_t i = 0; i < count; i++)
+	{
+		if (i == 0 ? times[i] < 0.0f : times[i] < times[i - 1])
+		{
+			times[i] = i == 0 ? 0.0f : times[i - 1];
+		}
+
+		values[i] = TClip::ValidateValue(values[i]);
+		if ((int)interpolations[i] < 0 || (int)interpolations[i] >= INTERPOLATIONS_COUNT)
+		{
+			interpolations[i] = Interpolation::Linear;
+		}
+	}
+
+	ChangeKeysCount(times.size());
+}
+
+template<typename TClip>
+size_t KeyframeTrack<TClip>::FindSegment(float time)
+{
+	// Playback moves forward by less than a segment most frames
+	if (cursor + 1 < times.size() && times[cursor] <= time)
+	{
+		if (time < times[cursor + 1])
+		{
+			return cursor;
+		}
+
+		if (cursor + 2 < times.size() && time < times[cursor + 2])
+		{
+			return ++cursor;
+		}
+	}
+
+	cursor = std::upper_bound(times.begin(), times.end(), time) - times.begin() - 1;
+	return cursor;
+}
+
+template<typename TClip>
+typename KeyframeTrack<TClip>::Value KeyframeTrack<TClip>::GetSlope(size_t key) const
+{
+	// Catmull-Rom tangent for non-uniform key times
+	const size_t previous = key == 0 ? key : key - 1;
+	const size_t next = key + 1 == times.size() ? key : key + 1;
+	const float duration = times[next] - times[previous];
+	if (duration <= 0.0f)
+	{
+		return Value(0.0f);
+	}
+
+	return (Traits::ToValue(values[next]) - Traits::ToValue(values[previous])) / duration;
+}
+
+template<typename TClip>
+typename KeyframeTrack<TClip>::Value KeyframeTrack<TClip>::EvaluateValue(float time)
+{
+	const size_t last = times.size() - 1;
+	if (time <= times[0])
+	{
+		return Traits::ToValue(values[0]);
+	}
+
+	if (time >= times[last])
+	{
+		return Traits::ToValue(values[last]);
+	}
+
+	const size_t key = FindSegment(time);
+	const float duration = times[key + 1] - times[key];
+	const float t = (time - times[key]) / duration;
+	const Value from = Traits::ToValue(values[key]);
+	const Value to = Traits::ToValue(values[key + 1]);
+	Value fromTangent;
+	Value toTangent;
+	switch (interpolations[key])
+	{
+	case Interpolation::Step:
+		return from;
+	case Interpolation::Linear:
+		return from + t * (to - from);
+	case Interpolation::CatmullRom:
+		fromTangent = GetSlope(key);
+		toTangent = GetSlope(key + 1);
+		break;
+	default:
+		fromTangent = outTangents[key];
+		toTangent = inTangents[key + 1];
+		break;
+	}
+
+	const float t2 = t * t;
+	const float t3 = t2 * t;
+	return (2.0f * t3 - 3.0f * t2 + 1.0f) * from
+		+ ((t3 - 2.0f * t2 + t) * duration) * fromTangent
+		+ (3.0f * t2 - 2.0f * t3) * to
+		+ ((t3 - t2) * duration) * toTangent;
+}
+
+template<typename TClip>
+void KeyframeTrack<TClip>::DrawUI()
+{
+	int keysCount = times.size();
+	if (ImGui::InputInt("Keys count", &keysCount))
+	{
+		ChangeKeysCount(keysCount);
+	}
+
+	int interpolationIndex = -1;
+	if (ImGui::Combo("Set all", &interpolationIndex, INTERPOLATION_NAMES, INTERPOLATIONS_COUNT))
+	{
+		std::fill(interpolations.begin(), interpolations.end(), (Interpolation)interpolationIndex);
+		this->Invalidate();
+	}
+
+	ImGui::Text("Range - %0.3f to %0.3f", GetStartTime(), GetEndTime());
+
+	// Only the visible rows of long tracks are submitted
+	char buffer[40];
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const int rows = std::min((int)times.size(), (int)VISIBLE_KEYS_COUNT);
+	ImGui::BeginChild("Keys", ImVec2(0.0f, rowHeight * rows + ImGui::GetStyle().WindowPadding.y * 2.0f), true);
+	ImGuiListClipper clipper;
+	clipper.Begin(times.size(), rowHeight);
+	while (clipper.Step())
+	{
+		for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+		{
+			sprintf_s(buffer, "K%d - %0.3f", i, times[i]);
+			if (ImGui::Selectable(buffer, selectedKey == i))
+			{
+				selectedKey = i;
+			}
+		}
+	}
+	clipper.End();
+	ImGui::EndChild();
+
+	DrawKeyUI(selectedKey);
+
+	const ImGuiTreeNodeFlags treeNodeFlags = ImGuiTreeNodeFlags_SpanAvailWidth
+		| ImGuiTreeNodeFlags_AllowItemOverlap
+		| ImGuiTreeNodeFlags_FramePadding;
+
+	if (ImGui::TreeNodeEx("Preview", treeNodeFlags))
+	{
+		DrawPreview();
+		ImGui::TreePop();
+	}
+}
+
+template<typename TClip>
+void KeyframeTrack<TClip>::DrawKeyUI(size_t key)
+{
+	// Times are kept sorted by clamping a key between its neighbours
+	float temp = times[key];
+	if (ImGui::DragFloat("Time", &temp, 0.01f))
+	{
+		const float minTime = key == 0 ? 0.0f : times[key - 1];
+		const float maxTime = key + 1 == times.size() ? FLT_MAX : times[key + 1];
+		times[key] = std::min(std::max(temp, minTime), maxTime);
+		this->Invalidate();
+	}
+
+	T previous = values[key];
+	TClip::DrawValueControl("Value", &values[key]);
+	values[key] = TClip::ValidateValue(values[key]);
+	if (values[key] != previous)
+	{
+		this->Invalidate();
+	}
+
+	int interpolationIndex = (int)interpolations[key];
+	if (ImGui::Combo("Interpolation", &interpolationIndex, INTERPOLATION_NAMES, INTERPOLATIONS_COUNT))
+	{
+		interpolations[key] = (Interpolation)interpolationIndex;
+		this->Invalidate();
+	}
+
+	if (key > 0 && interpolations[key - 1] == Interpolation::Hermite)
+	{
+		DrawTangentControl("In tangent", &inTangents[key]);
+	}
+
+	if (key + 1 < times.size() && interpolations[key] == Interpolation::Hermite)
+	{
+		DrawTangentControl("Out tangent", &outTangents[key]);
+	}
+}
+
+template<typename TClip>
+void KeyframeTrack<TClip>::DrawTangentControl(const char* name, Value* tangent)
+{
+	if (ImGui::DragScalarN(name, ImGuiDataType_Float, &Traits::Component(*tangent, 0), Traits::COMPONENTS, 0.01f))
+	{
+		this->Invalidate();
+	}
+}
+
+template<typename TClip>
+void KeyframeTrack<TClip>::DrawPreview()
+{
+	static const char* COMPONENT_NAMES[] = { "X", "Y", "Z", "W" };
+
+	ImGui::SliderFloat("Time", &previewTime, GetStartTime(), GetEndTime());
+	const Value value = EvaluateValue(previewTime);
+	for (int component = 0; component < Traits::COMPONENTS; component++)
+	{
+		ImGui::Text("%s - %0.3f", COMPONENT_NAMES[component], Traits::Component(value, component));
+	}
+
+	float plot[Traits::COMPONENTS][PLOT_LINES_FREQUENCY + 1];
+	const float step = (GetEndTime() - GetStartTime()) / PLOT_LINES_FREQUENCY;
+	for (size_t i = 0; i <= PLOT_LINES_FREQUENCY; i++)
+	{
+		const Value sample = EvaluateValue(GetStartTime() + step * i);
+		for (int component = 0; component < Traits::COMPONENTS; component++)
+		{
+			plot[component][i] = Traits::Component(sample, component);
+		}
+	}
+
+	for (int component = 0; component < Traits::COMPONENTS; component++)
+	{
+		ImGui::PlotLines(COMPONENT_NAMES[component], plot[component], PLOT_LINES_FREQUENCY + 1);
+	}
+}
+
+template<typename TClip>
+template<class Archive>
+void KeyframeTrack<TClip>::Save(Archive& archive) const
+{
+	archive(CEREAL_NVP_("BaseInfo", cereal::base_class<AnimationClip>(this)));
+	archive(CEREAL_NVP_("DefaultValue", defaultValue));
+	archive(CEREAL_NVP_("Times", times));
+	archive(CEREAL_NVP_("Values", values));
+	archive(CEREAL_NVP_("Interpolations", interpolations));
+	archive(CEREAL_NVP_("InTangents", inTangents));
+	archive(CEREAL_NVP_("OutTangents", outTangents));
+}
+
+template<typename TClip>
+template<class Archive>
+void KeyframeTrack<TClip>::Load(Archive& archive)
+{
+	archive(CEREAL_NVP_("BaseInfo", cereal::base_class<AnimationClip>(this)));
+	archive(CEREAL_NVP_("DefaultValue", defaultValue));
+	archive(CEREAL_NVP_("Times", times));
+	archive(CEREAL_NVP_("Values", values));
+	archive(CEREAL_NVP_("Interpolations", interpolations));
+	archive(CEREAL_NVP_("InTangents", inTangents));
+	archive(CEREAL_NVP_("OutTangents", outTangents));
+	defaultValue = TClip::ValidateValue(defaultValue);
+	cursor = 0;
+	Validate();
+}
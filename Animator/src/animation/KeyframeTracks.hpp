@@ -0,0 +1,15 @@
+#pragma once
+
+#include "KeyframeTrack.hpp"
+#include "Vec3AnimationClip.hpp"
+#include "ParameterAnimationClip.hpp"
+#include "Color3AnimationClip.hpp"
+#include "Color4AnimationClip.hpp"
+#include "ShininessAnimationClip.hpp"
+
+typedef KeyframeTrack<Vec3AnimationClip> Vec3KeyframeTrack;
+typedef KeyframeTrack<IntAnimationClip> IntKeyframeTrack;
+typedef KeyframeTrack<ParameterAnimationClip> ParameterKeyframeTrack;
+typedef KeyframeTrack<Color3AnimationClip> Color3KeyframeTrack;
+typedef KeyframeTrack<Color4AnimationClip> Color4KeyframeTrack;
+typedef KeyframeTrack<ShininessAnimationClip> ShininessKeyframeTrack;
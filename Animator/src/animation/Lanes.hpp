@@ -0,0 +1,29 @@
+#pragma once
+
+#include <immintrin.h>
+
+// SIMD register of 4 (SSE) or 8 (AVX) floats and the operations the batch
+// kernels use on it. Only included by translation units.
+#if defined(__AVX__)
+typedef __m256 Lanes;
+#define LANES_SET1 _mm256_set1_ps
+#define LANES_LOAD _mm256_loadu_ps
+#define LANES_STORE _mm256_storeu_ps
+#define LANES_ADD _mm256_add_ps
+#define LANES_SUB _mm256_sub_ps
+#define LANES_MUL _mm256_mul_ps
+#define LANES_MIN _mm256_min_ps
+#define LANES_MAX _mm256_max_ps
+#else
+typedef __m128 Lanes;
+#define LANES_SET1 _mm_set1_ps
+#define LANES_LOAD _mm_loadu_ps
+#define LANES_STORE _mm_storeu_ps
+#define LANES_ADD _mm_add_ps
+#define LANES_SUB _mm_sub_ps
+#define LANES_MUL _mm_mul_ps
+#define LANES_MIN _mm_min_ps
+#define LANES_MAX _mm_max_ps
+#endif
+
+static const size_t LANES_COUNT = sizeof(Lanes) / sizeof(float);
@@ -2,7 +2,7 @@
 
 #include <cmath>
 
-int ParameterAnimationClip::Validate(const int& value)
+int ParameterAnimationClip::ValidateValue(const int& value)
 {
 	if (value < 3)
 	{
@@ -11,3 +11,8 @@ int ParameterAnimationClip::Validate(const int& value)
 
 	return value;
 }
+
+int ParameterAnimationClip::Validate(const int& value)
+{
+	return ValidateValue(value);
+}
@@ -7,6 +7,8 @@ class ParameterAnimationClip : public IntAnimationClip
 protected:
 	int Validate(const int& value) override;
 public:
+	static int ValidateValue(const int& value);
+
 	ParameterAnimationClip(const std::string& propertyName, int defaultValue)
 		: IntAnimationClip(propertyName, 3) { }
 
@@ -7,11 +7,15 @@ class ShininessAnimationClip : public TypedAnimationClip<float>
 protected:
 	float Validate(const float& value) override;
 public:
+	static float ValidateValue(const float& value);
+
 	ShininessAnimationClip(const std::string& propertyName, float defaultValue)
 		: TypedAnimationClip<float>(propertyName, defaultValue) { }
 
 	ShininessAnimationClip() { }
 
+	static void DrawValueControl(const char* name, float* state);
+
 	void DrawControl(const char* name, float* state) override;
 	void DrawPreview(float t) override;
 };
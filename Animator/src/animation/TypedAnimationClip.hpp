@@ -1,12 +1,18 @@
 #pragma once
 
+#include <cfloat>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
 #include <imgui/imgui.h>
 #include "../ConfiguredCereal.hpp"
 
-#include "AnimationClip.hpp"
+#include "ValueAnimationClip.hpp"
+#include "BezierCurve.hpp"
+#include "BakedCurve.hpp"
 
 template<typename T>
-class TypedAnimationClip : public AnimationClip
+class TypedAnimationClip : public ValueAnimationClip<T>
 {
 private:
 	static const int MIN_STATES_COUNT = 2;
@@ -16,9 +22,24 @@ private:
 	std::vector<T> states;
 	float previewT = 0.0f;
 
+	BezierCurve<T> curve;
+	bool curveDirty = true;
+
+	float bakeRate = 60.0f;
+	float bakeTolerance = 0.001f;
+	BakedCurve<T> bakedCurve;
+	size_t bakedVersion = SIZE_MAX;
+
+	std::vector<float> batchParameters;
+	std::vector<typename BezierTraits<T>::Value> batchValues;
+	std::vector<T> plotSamples;
+	bool plotSamplesDirty = true;
+
 	T defaultValue;
 
 	void ChangeStatesCount(int value);
+	void InvalidateCurve();
+	void DrawBakingUI();
 protected:
 	static const int PLOT_LINES_FREQUENCY = 20;
 
@@ -28,19 +49,35 @@ protected:
 	virtual T Validate(const T& value) { return value; };
 
 	T EvaluateParameter(float t);
+	void EvaluateParameters(const float* parameters, T* results, size_t count);
+
+	// Curve sampled at PLOT_LINES_FREQUENCY + 1 uniform parameters, kept
+	// until the states change
+	const std::vector<T>& GetPlotSamples();
+
+	// Plots one float component of the cached samples in place
+	void PlotComponent(const char* label, int component);
 public:
+	typedef T ValueType;
+
+	static T ValidateValue(const T& value) { return value; }
+
 	TypedAnimationClip(const std::string& propertyName, T defaultValue)
-		: AnimationClip(propertyName), defaultValue(defaultValue)
+		: ValueAnimationClip<T>(propertyName), defaultValue(defaultValue)
 	{
 		ChangeStatesCount(MIN_STATES_COUNT);
 	}
 
 	TypedAnimationClip() { }
 
-	const float GetStartTime() const { return startTime; }
-	const float GetEndTime() const { return endTime; }
+	float GetStartTime() const override { return startTime; }
+	float GetEndTime() const override { return endTime; }
+
+	const BezierCurve<T>& GetCurve();
+	const BakedCurve<T>& GetBakedCurve();
 
-	T Evaluate(float time);
+	T Evaluate(float time) override;
+	void Evaluate(const float* times, T* results, size_t count);
 	void DrawUI() override final;
 
 	template<class Archive>
@@ -64,28 +101,124 @@ void TypedAnimationClip<T>::ChangeStatesCount(int value)
 	{
 		states[i] = Validate(defaultValue);
 	}
+
+	InvalidateCurve();
+}
+
+template<typename T>
+void TypedAnimationClip<T>::InvalidateCurve()
+{
+	curveDirty = true;
+	plotSamplesDirty = true;
+	this->Invalidate();
+}
+
+template<typename T>
+const BezierCurve<T>& TypedAnimationClip<T>::GetCurve()
+{
+	if (curveDirty)
+	{
+		curve.SetPoints(states);
+		curveDirty = false;
+	}
+
+	return curve;
+}
+
+template<typename T>
+const BakedCurve<T>& TypedAnimationClip<T>::GetBakedCurve()
+{
+	if (bakedVersion != this->GetVersion())
+	{
+		bakedCurve.Bake(GetCurve(), startTime, endTime, bakeRate, bakeTolerance);
+		bakedVersion = this->GetVersion();
+	}
+
+	return bakedCurve;
 }
 
 template<typename T>
 T TypedAnimationClip<T>::EvaluateParameter(float t)
 {
-	T* points = new T[states.size()];
-	for (size_t i = 0; i < states.size(); i++)
+	return GetCurve().Evaluate(t);
+}
+
+template<typename T>
+void TypedAnimationClip<T>::EvaluateParameters(const float* parameters, T* results, size_t count)
+{
+	typedef typename BezierTraits<T>::Value Value;
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Value types made of floats are written in place
+	const BezierCurve<T>& curve = GetCurve();
+	if (std::is_same<Value, T>::value)
 	{
-		points[i] = states[i];
+		curve.EvaluateValues(parameters, reinterpret_cast<Value*>(results), count);
+		return;
 	}
 
-	for (int limit = states.size(); limit > 1; limit--)
+	batchValues.resize(count);
+	curve.EvaluateValues(parameters, &batchValues[0], count);
+	for (size_t i = 0; i < count; i++)
 	{
-		for (int i = 0; i < limit - 1; i++)
+		results[i] = BezierTraits<T>::FromValue(batchValues[i]);
+	}
+}
+
+template<typename T>
+const std::vector<T>& TypedAnimationClip<T>::GetPlotSamples()
+{
+	if (plotSamplesDirty)
+	{
+		float parameters[PLOT_LINES_FREQUENCY + 1];
+		const float step = 1.0f / PLOT_LINES_FREQUENCY;
+		for (size_t i = 0; i <= PLOT_LINES_FREQUENCY; i++)
 		{
-			points[i] = (T)((1 - t) * points[i] + t * points[i + 1]);
+			parameters[i] = step * i;
 		}
+
+		plotSamples.resize(PLOT_LINES_FREQUENCY + 1);
+		EvaluateParameters(parameters, &plotSamples[0], plotSamples.size());
+		plotSamplesDirty = false;
 	}
 
-	T result = points[0];
-	delete[] points;
-	return result;
+	return plotSamples;
+}
+
+template<typename T>
+void TypedAnimationClip<T>::PlotComponent(const char* label, int component)
+{
+	const std::vector<T>& samples = GetPlotSamples();
+	ImGui::PlotLines(
+		label,
+		reinterpret_cast<const float*>(&samples[0]) + component,
+		samples.size(),
+		0,
+		nullptr,
+		FLT_MAX,
+		FLT_MAX,
+		ImVec2(0.0f, 0.0f),
+		sizeof(T)
+	);
+}
+
+template<typename T>
+void TypedAnimationClip<T>::Evaluate(const float* times, T* results, size_t count)
+{
+	const float timeDelta = endTime - startTime;
+	const float inverseDelta = timeDelta == 0.0f ? 0.0f : 1.0f / timeDelta;
+	batchParameters.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const float time = std::min(std::max(times[i], startTime), endTime);
+		batchParameters[i] = (time - startTime) * inverseDelta;
+	}
+
+	EvaluateParameters(batchParameters.data(), results, count);
 }
 
 template<typename T>
@@ -117,6 +250,7 @@ void TypedAnimationClip<T>::DrawUI()
 		}
 
 		startTime = temp;
+		this->Invalidate();
 	}
 
 	temp = endTime;
@@ -128,11 +262,13 @@ void TypedAnimationClip<T>::DrawUI()
 		}
 
 		endTime = temp;
+		this->Invalidate();
 	}
 
 	if (endTime < startTime)
 	{
 		endTime = startTime;
+		this->Invalidate();
 	}
 
 	int statesCount = states.size();
@@ -146,8 +282,13 @@ void TypedAnimationClip<T>::DrawUI()
 	for (int i = 0; i < statesCount; i++)
 	{
 		sprintf_s(buffer, "S%d", i);
+		T previous = states[i];
 		DrawControl(buffer, &states[i]);
 		states[i] = Validate(states[i]);
+		if (states[i] != previous)
+		{
+			InvalidateCurve();
+		}
 	}
 
 	const ImGuiTreeNodeFlags treeNodeFlags = ImGuiTreeNodeFlags_SpanAvailWidth
@@ -161,6 +302,40 @@ void TypedAnimationClip<T>::DrawUI()
 		DrawPreview(previewT);
 		ImGui::TreePop();
 	}
+
+	open = ImGui::TreeNodeEx("Baking", treeNodeFlags);
+	if (open)
+	{
+		DrawBakingUI();
+		ImGui::TreePop();
+	}
+}
+
+template<typename T>
+void TypedAnimationClip<T>::DrawBakingUI()
+{
+	float temp = bakeRate;
+	if (ImGui::DragFloat("Rate", &temp, 1.0f, 1.0f, 10000.0f))
+	{
+		bakeRate = temp < 1.0f ? 1.0f : temp;
+		this->Invalidate();
+	}
+
+	temp = bakeTolerance;
+	if (ImGui::DragFloat("Tolerance", &temp, 0.0001f, 0.0f, 1.0f, "%.5f"))
+	{
+		bakeTolerance = temp < 0.0f ? 0.0f : temp;
+		this->Invalidate();
+	}
+
+	const BakedCurve<T>& baked = GetBakedCurve();
+	ImGui::Text(
+		"Samples: %zu (%.1f KB), rate: %.1f, error: %.5f",
+		baked.GetSamplesCount(),
+		baked.GetMemorySize() / 1024.0f,
+		baked.GetRate(),
+		baked.GetError()
+	);
 }
 
 template<typename T>
@@ -172,6 +347,8 @@ void TypedAnimationClip<T>::Save(Archive& archive) const
 	archive(CEREAL_NVP_("EndTime", endTime));
 	archive(CEREAL_NVP_("DefaultValue", defaultValue));
 	archive(CEREAL_NVP_("States", states));
+	archive(CEREAL_NVP_("BakeRate", bakeRate));
+	archive(CEREAL_NVP_("BakeTolerance", bakeTolerance));
 }
 
 template<typename T>
@@ -183,6 +360,8 @@ void TypedAnimationClip<T>::Load(Archive& archive)
 	archive(CEREAL_NVP_("EndTime", endTime));
 	archive(CEREAL_NVP_("DefaultValue", defaultValue));
 	archive(CEREAL_NVP_("States", states));
+	LoadOptionalNVP(archive, "BakeRate", bakeRate);
+	LoadOptionalNVP(archive, "BakeTolerance", bakeTolerance);
 	if (startTime < 0.0f)
 	{
 		startTime = 0.0f;
@@ -198,8 +377,20 @@ void TypedAnimationClip<T>::Load(Archive& archive)
 		endTime = startTime;
 	}
 
+	if (bakeRate < 1.0f)
+	{
+		bakeRate = 1.0f;
+	}
+
+	if (bakeTolerance < 0.0f)
+	{
+		bakeTolerance = 0.0f;
+	}
+
 	if (states.size() < MIN_STATES_COUNT)
 	{
 		ChangeStatesCount(MIN_STATES_COUNT);
 	}
+
+	InvalidateCurve();
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "AnimationClip.hpp"
+
+// Clip that drives a property of type T, whatever way the value is authored
+template<typename T>
+class ValueAnimationClip : public AnimationClip
+{
+public:
+	ValueAnimationClip(const std::string& propertyName)
+		: AnimationClip(propertyName) { }
+
+	ValueAnimationClip() { }
+
+	virtual T Evaluate(float time) = 0;
+
+	// The value is constant before the start time and after the end time
+	virtual float GetStartTime() const = 0;
+	virtual float GetEndTime() const = 0;
+};
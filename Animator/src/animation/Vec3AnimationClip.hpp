@@ -12,6 +12,8 @@ public:
 
 	Vec3AnimationClip() { }
 
+	static void DrawValueControl(const char* name, glm::vec3* state);
+
 	void DrawControl(const char* name, glm::vec3* state) override;
 	void DrawPreview(float t) override;
 };
@@ -0,0 +1,298 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::workers;
+std::vector<std::thread> JobSystem::threads;
+std::mutex JobSystem::sleepMutex;
+std::condition_variable JobSystem::wake;
+std::atomic<bool> JobSystem::stopping(false);
+
+std::atomic<size_t> JobSystem::queuedJobs(0);
+std::atomic<size_t> JobSystem::peakQueuedJobs(0);
+std::atomic<size_t> JobSystem::executedJobs(0);
+std::atomic<size_t> JobSystem::stolenJobs(0);
+
+thread_local size_t JobSystem::workerIndex = 0;
+
+void JobSystem::Initialize(size_t workersCount)
+{
+	if (!workers.empty())
+	{
+		return;
+	}
+
+	if (workersCount == 0)
+	{
+		const size_t hardwareThreads = std::thread::hardware_concurrency();
+		workersCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	stopping = false;
+	for (size_t i = 0; i <= workersCount; i++)
+	{
+		workers.push_back(std::unique_ptr<Worker>(new Worker()));
+	}
+
+	for (size_t i = 1; i <= workersCount; i++)
+	{
+		threads.push_back(std::thread(&JobSystem::WorkerLoop, i));
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+
+	wake.notify_all();
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+
+	threads.clear();
+	workers.clear();
+}
+
+void JobSystem::Push(const JobHandle& job)
+{
+	// Without workers jobs run on the spot
+	if (workers.empty())
+	{
+		Execute(job);
+		return;
+	}
+
+	Worker& worker = *workers[workerIndex];
+	{
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		worker.jobs.push_back(job);
+	}
+
+	const size_t queued = ++queuedJobs;
+	size_t peak = peakQueuedJobs;
+	while (queued > peak && !peakQueuedJobs.compare_exchange_weak(peak, queued)) { }
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+	}
+
+	wake.notify_one();
+}
+
+JobSystem::JobHandle JobSystem::Pop()
+{
+	Worker& own = *workers[workerIndex];
+	{
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			JobHandle job = own.jobs.back();
+			own.jobs.pop_back();
+			queuedJobs--;
+			return job;
+		}
+	}
+
+	for (size_t offset = 1; offset < workers.size(); offset++)
+	{
+		Worker& victim = *workers[(workerIndex + offset) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			JobHandle job = victim.jobs.front();
+			victim.jobs.pop_front();
+			queuedJobs--;
+			stolenJobs++;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+bool JobSystem::RunQueued()
+{
+	if (workers.empty())
+	{
+		return false;
+	}
+
+	JobHandle job = Pop();
+	if (job == nullptr)
+	{
+		return false;
+	}
+
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	// Escaping a worker thread would terminate the application
+	try
+	{
+		job->function();
+	}
+	catch (...)
+	{
+		job->exception = std::current_exception();
+	}
+
+	job->function = nullptr;
+	executedJobs++;
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->mutex);
+		job->finished = true;
+		continuations.swap(job->continuations);
+	}
+
+	for (size_t i = 0; i < continuations.size(); i++)
+	{
+		Release(continuations[i]);
+	}
+}
+
+void JobSystem::Release(const JobHandle& job)
+{
+	if (--job->dependencies == 0)
+	{
+		Push(job);
+	}
+}
+
+void JobSystem::WorkerLoop(size_t index)
+{
+	workerIndex = index;
+	while (true)
+	{
+		if (RunQueued())
+		{
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		if (stopping && queuedJobs == 0)
+		{
+			return;
+		}
+
+		wake.wait(lock, [] { return stopping || queuedJobs > 0; });
+	}
+}
+
+JobSystem::JobHandle JobSystem::Run(Function function)
+{
+	JobHandle job = std::make_shared<Job>(function, 1);
+	Release(job);
+	return job;
+}
+
+JobSystem::JobHandle JobSystem::Run(Function function, const std::vector<JobHandle>& dependencies)
+{
+	// The extra dependency keeps the job from being queued while it is being linked
+	JobHandle job = std::make_shared<Job>(function, dependencies.size() + 1);
+	for (size_t i = 0; i < dependencies.size(); i++)
+	{
+		Job& dependency = *dependencies[i];
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.finished)
+		{
+			job->dependencies--;
+		}
+		else
+		{
+			dependency.continuations.push_back(job);
+		}
+	}
+
+	Release(job);
+	return job;
+}
+
+JobSystem::JobHandle JobSystem::Then(const JobHandle& dependency, Function function)
+{
+	return Run(function, std::vector<JobHandle>{ dependency });
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	while (!job->finished)
+	{
+		if (!RunQueued())
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	if (job->exception)
+	{
+		std::rethrow_exception(job->exception);
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, const RangeFunction& function)
+{
+	grain = std::max<size_t>(grain, 1);
+	if (count <= grain || workers.empty())
+	{
+		if (count > 0)
+		{
+			function(0, count);
+		}
+
+		return;
+	}
+
+	// The queued chunks reference the function, so none may be left running
+	// when an exception leaves this frame
+	std::exception_ptr exception;
+	std::vector<JobHandle> jobs;
+	try
+	{
+		for (size_t begin = grain; begin < count; begin += grain)
+		{
+			const size_t end = std::min(begin + grain, count);
+			jobs.push_back(Run([&function, begin, end]() { function(begin, end); }));
+		}
+
+		function(0, grain);
+	}
+	catch (...)
+	{
+		exception = std::current_exception();
+	}
+
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		try
+		{
+			Wait(jobs[i]);
+		}
+		catch (...)
+		{
+			if (!exception)
+			{
+				exception = std::current_exception();
+			}
+		}
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void JobSystem::ResetStatistics()
+{
+	peakQueuedJobs = size_t(queuedJobs);
+	executedJobs = 0;
+	stolenJobs = 0;
+}
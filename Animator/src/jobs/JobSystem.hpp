@@ -0,0 +1,97 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+// Runs jobs on worker threads. Every worker owns a deque: it pushes and
+// pops its jobs at the back, idle workers steal from the front of the
+// others. A thread waiting for a job runs queued jobs in the meantime.
+// Jobs must not touch GL, it stays on the context thread
+class JobSystem
+{
+public:
+	class Job;
+
+	typedef std::shared_ptr<Job> JobHandle;
+	typedef std::function<void()> Function;
+	typedef std::function<void(size_t begin, size_t end)> RangeFunction;
+
+	class Job
+	{
+		friend class JobSystem;
+	private:
+		Function function;
+		std::atomic<size_t> dependencies;
+		std::atomic<bool> finished;
+		std::mutex mutex;
+		std::vector<JobHandle> continuations;
+		// Thrown by the function, rethrown by Wait
+		std::exception_ptr exception;
+	public:
+		Job(Function function, size_t dependencies)
+			: function(function), dependencies(dependencies), finished(false) { }
+
+		bool IsFinished() const { return finished; }
+	};
+private:
+	struct Worker
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	// The first deque belongs to the main thread, which is not a worker
+	static std::vector<std::unique_ptr<Worker>> workers;
+	static std::vector<std::thread> threads;
+	static std::mutex sleepMutex;
+	static std::condition_variable wake;
+	static std::atomic<bool> stopping;
+
+	static std::atomic<size_t> queuedJobs;
+	static std::atomic<size_t> peakQueuedJobs;
+	static std::atomic<size_t> executedJobs;
+	static std::atomic<size_t> stolenJobs;
+
+	static thread_local size_t workerIndex;
+
+	static void Push(const JobHandle& job);
+	static JobHandle Pop();
+	static bool RunQueued();
+	static void Execute(const JobHandle& job);
+	static void Release(const JobHandle& job);
+	static void WorkerLoop(size_t index);
+public:
+	// Zero workers means one less than the hardware threads
+	static void Initialize(size_t workersCount = 0);
+	static void Shutdown();
+
+	static JobHandle Run(Function function);
+	static JobHandle Run(Function function, const std::vector<JobHandle>& dependencies);
+
+	// Continuation, queued once the dependency has finished
+	static JobHandle Then(const JobHandle& dependency, Function function);
+
+	// Rethrows the exception the job function threw. Continuations of a
+	// failed job still run
+	static void Wait(const JobHandle& job);
+
+	// Calls the function for chunks of at most grain indices, the calling
+	// thread takes part and returns when all chunks are done. An exception
+	// of a chunk is rethrown once every chunk has finished
+	static void ParallelFor(size_t count, size_t grain, const RangeFunction& function);
+
+	static size_t GetWorkersCount() { return threads.size(); }
+	static size_t GetQueuedJobs() { return queuedJobs; }
+	static size_t GetPeakQueuedJobs() { return peakQueuedJobs; }
+	static size_t GetExecutedJobs() { return executedJobs; }
+	static size_t GetStolenJobs() { return stolenJobs; }
+
+	static void ResetStatistics();
+};
@@ -2,6 +2,8 @@
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../ChangeTracker.hpp"
+
 void Transform::UpdateMatrix()
 {
 	matrix = glm::mat4(1.0f);
@@ -10,24 +12,36 @@ void Transform::UpdateMatrix()
 	matrix = glm::rotate(matrix, glm::radians(rotation[1]), glm::vec3(0.0f, 1.0f, 0.0f));
 	matrix = glm::rotate(matrix, glm::radians(rotation[2]), glm::vec3(0.0f, 0.0f, 1.0f));
 	matrix = glm::scale(matrix, scale);
+	normalMatrix = glm::transpose(glm::inverse(glm::mat3(matrix)));
+	version = NextChangeVersion();
 }
 
-void Transform::SetTranslation(glm::vec3 translation)
+void Transform::Set(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale)
 {
+	if (this->translation == translation && this->rotation == rotation && this->scale == scale)
+	{
+		return;
+	}
+
 	this->translation = translation;
+	this->rotation = rotation;
+	this->scale = scale;
 	UpdateMatrix();
 }
 
+void Transform::SetTranslation(glm::vec3 translation)
+{
+	Set(translation, rotation, scale);
+}
+
 void Transform::SetRotation(glm::vec3 rotation)
 {
-	this->rotation = rotation;
-	UpdateMatrix();
+	Set(translation, rotation, scale);
 }
 
 void Transform::SetScale(glm::vec3 scale)
 {
-	this->scale = scale;
-	UpdateMatrix();
+	Set(translation, rotation, scale);
 }
 
 const glm::vec3& Transform::GetTranslation() const
@@ -49,3 +63,8 @@ const glm::mat4& Transform::GetMatrix() const
 {
 	return matrix;
 }
+
+const glm::mat3& Transform::GetNormalMatrix() const
+{
+	return normalMatrix;
+}
@@ -9,6 +9,8 @@ private:
 	glm::vec3 rotation;
 	glm::vec3 scale;
 	glm::mat4 matrix;
+	glm::mat3 normalMatrix;
+	size_t version = 0;
 
 	void UpdateMatrix();
 public:
@@ -19,6 +21,8 @@ public:
 	}
 	Transform() : Transform(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f)) { }
 
+	// Matrices are recomputed only when one of the values differs
+	void Set(const glm::vec3& translation, const glm::vec3& rotation, const glm::vec3& scale);
 	void SetTranslation(glm::vec3 translation);
 	void SetRotation(glm::vec3 rotation);
 	void SetScale(glm::vec3 scale);
@@ -26,4 +30,8 @@ public:
 	const glm::vec3& GetRotation() const;
 	const glm::vec3& GetScale() const;
 	const glm::mat4& GetMatrix() const;
+	const glm::mat3& GetNormalMatrix() const;
+
+	// Changes whenever the matrices change
+	size_t GetVersion() const { return version; }
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include "Vertex.hpp"
+
+// 16 byte vertex: half float position, packed signed normal and
+// normalized 16-bit texture coordinates. Shaders read it like Vertex
+struct CompactVertex
+{
+	uint64_t position;
+	uint32_t normal;
+	uint32_t uv;
+
+	static CompactVertex Pack(const Vertex& vertex)
+	{
+		return CompactVertex{
+			glm::packHalf4x16(glm::vec4(vertex.position, 1.0f)),
+			glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f)),
+			glm::packUnorm2x16(vertex.uv)
+		};
+	}
+};
+
+// Octahedral encoding of a unit vector for BufferElement::Type::Octahedral
+inline uint32_t PackOctahedral(const glm::vec3& normal)
+{
+	glm::vec2 folded = glm::vec2(normal) / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+	if (normal.z < 0.0f)
+	{
+		const glm::vec2 sign = glm::vec2(folded.x >= 0.0f ? 1.0f : -1.0f, folded.y >= 0.0f ? 1.0f : -1.0f);
+		folded = (1.0f - glm::abs(glm::vec2(folded.y, folded.x))) * sign;
+	}
+
+	return glm::packSnorm2x16(folded);
+}
@@ -1,172 +1,413 @@
 #include "Mesh.hpp"
 
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
 #include "GL/glew.h"
 
-void Mesh::AddPrismBase(size_t n, PrismBaseType type, Mesh& mesh)
+#include "CompactVertex.hpp"
+#include "../renderer/IndexBuffer.hpp"
+#include "../jobs/JobSystem.hpp"
+
+std::shared_ptr<GeometryArena> Mesh::arenas[2];
+std::shared_ptr<VertexArray> Mesh::emptyVertexArray;
+
+void Mesh::ComputePrismCircle(size_t n, size_t begin, size_t end, glm::vec2* circle)
 {
-	if (n < 3)
+	// Angles in double keep neighbouring points distinct for millions of segments
+	const double step = 2.0 * PI_DOUBLE / n;
+	for (size_t i = begin; i < end; i++)
 	{
-		return;
+		const double t = step * (i % n) + PRISM_START_T;
+		circle[i] = glm::vec2{ float(std::cos(t)), float(std::sin(t)) };
 	}
+}
 
+void Mesh::AddPrismBase(
+	size_t n,
+	PrismBaseType type,
+	const glm::vec2* circle,
+	size_t begin,
+	size_t end,
+	Vertex* verticies
+)
+{
 	const float radius = PRISM_RADIUS;
 	const float uvRadius = 0.25f;
 	const float y = type == PrismBaseType::Top ? PRISM_HEIGHT / 2 : -PRISM_HEIGHT / 2;
-	const float startT = PRISM_START_T;
 
 	const glm::vec3 normal = type == PrismBaseType::Top
 		? glm::vec3{ 0.0f, 1.0f, 0.0f }
 		: glm::vec3{ 0.0f, -1.0f, 0.0f };
 
-	glm::vec3 center = glm::vec3{ 0, y, 0 };
-	glm::vec3 previousPoint = glm::vec3{ radius * cos(startT), y, radius * sin(startT) };
-
-	glm::vec2 centerUV = type == PrismBaseType::Top ? glm::vec2{ 0.25f, 0.75f } : glm::vec2{ 0.75f, 0.75f };
-	glm::vec2 previousUV = glm::vec2{ uvRadius * cos(startT), uvRadius * sin(startT) } + centerUV;
+	const glm::vec2 centerUV = type == PrismBaseType::Top ? glm::vec2{ 0.25f, 0.75f } : glm::vec2{ 0.75f, 0.75f };
+	if (begin == 0)
+	{
+		verticies[0] = Vertex{ glm::vec3{ 0, y, 0 }, normal, centerUV };
+	}
 
-	for (size_t i = 0; i < n; i++)
+	Vertex* vertex = verticies + 1 + begin * PRISM_BASE_VERTICIES;
+	for (size_t i = begin; i < end; i++)
 	{
-		const size_t k = (i + 1) % n;
-		const float t = 2 * PI * k / n + startT;
-		const float cost = cos(t);
-		const float sint = sin(t);
+		const glm::vec2 point = circle[i];
+		*vertex++ = Vertex{ glm::vec3{ radius * point[0], y, radius * point[1] }, normal, uvRadius * point + centerUV };
+	}
+}
 
-		const glm::vec2 coords{ radius * cost, radius * sint };
-		const glm::vec2 uv = glm::vec2{ uvRadius * cost, uvRadius * sint } + centerUV;
-		const glm::vec3 point = glm::vec3{ coords[0], y, coords[1] };
+void Mesh::AddPrismSideFaces(size_t n, const glm::vec2* circle, size_t begin, size_t end, Vertex* verticies)
+{
+	const float radius = PRISM_RADIUS;
+	const float halfHeight = PRISM_HEIGHT / 2;
+
+	Vertex* vertex = verticies + begin * PRISM_SIDE_VERTICIES;
+	for (size_t i = begin; i < end; i++)
+	{
+		const glm::vec2 previous = radius * circle[i];
+		const glm::vec2 next = radius * circle[i + 1];
+
+		const glm::vec3 previousTopPoint = glm::vec3{ previous[0], halfHeight, previous[1] };
+		const glm::vec3 previousBottomPoint = glm::vec3{ previous[0], -halfHeight, previous[1] };
+		const glm::vec3 topPoint = glm::vec3{ next[0], halfHeight, next[1] };
+		const glm::vec3 bottomPoint = glm::vec3{ next[0], -halfHeight, next[1] };
+
+		// Points along the bisector of the segment, unlike the cross product of
+		// its edges it stays accurate when the edge shrinks for large N
+		const glm::vec2 bisector = circle[i] + circle[i + 1];
+		const glm::vec3 normal = glm::normalize(glm::vec3{ bisector[0], 0.0f, bisector[1] });
+
+		// Faces are flat, so a face shares its vertices only between its own two triangles
+		*vertex++ = Vertex{ previousBottomPoint, normal, glm::vec2{ float(i) / n, 0.0f } };
+		*vertex++ = Vertex{ previousTopPoint, normal, glm::vec2{ float(i) / n, 0.5f } };
+		*vertex++ = Vertex{ bottomPoint, normal, glm::vec2{ float(i + 1) / n, 0.0f } };
+		*vertex++ = Vertex{ topPoint, normal, glm::vec2{ float(i + 1) / n, 0.5f } };
+	}
+}
 
-		mesh.verticies.push_back(Vertex{ center, normal, centerUV });
-		mesh.verticies.push_back(Vertex{ point, normal, uv });
-		mesh.verticies.push_back(Vertex{ previousPoint, normal, previousUV });
+template<typename TIndex>
+void Mesh::AddPrismIndices(size_t n, size_t begin, size_t end, TIndex* indices)
+{
+	const size_t topBase = n * PRISM_SIDE_VERTICIES;
+	const size_t bottomBase = topBase + 1 + n * PRISM_BASE_VERTICIES;
 
-		previousPoint = point;
-		previousUV = uv;
+	TIndex* side = indices + begin * PRISM_SIDE_INDICES;
+	TIndex* top = indices + n * PRISM_SIDE_INDICES + begin * PRISM_BASE_INDICES;
+	TIndex* bottom = top + n * PRISM_BASE_INDICES;
+	for (size_t i = begin; i < end; i++)
+	{
+		const TIndex face = TIndex(i * PRISM_SIDE_VERTICIES);
+		*side++ = face;
+		*side++ = face + 1;
+		*side++ = face + 2;
+		*side++ = face + 2;
+		*side++ = face + 1;
+		*side++ = face + 3;
+
+		const size_t next = (i + 1) % n;
+		*top++ = TIndex(topBase);
+		*top++ = TIndex(topBase + 1 + next);
+		*top++ = TIndex(topBase + 1 + i);
+
+		*bottom++ = TIndex(bottomBase);
+		*bottom++ = TIndex(bottomBase + 1 + next);
+		*bottom++ = TIndex(bottomBase + 1 + i);
 	}
 }
 
-void Mesh::AddPrismSideFaces(size_t n, Mesh& mesh)
+template<typename TIndex>
+void Mesh::GeneratePrismIndexed(size_t n, std::vector<Vertex>& verticies, std::vector<TIndex>& indices)
 {
+	verticies.clear();
+	indices.clear();
 	if (n < 3)
 	{
 		return;
 	}
 
-	const float radius = PRISM_RADIUS;
-	const float halfHeight = PRISM_HEIGHT / 2;
-	const float startT = PRISM_START_T;
+	// One table of segment boundaries for the sides and both caps, the last point closes the circle
+	std::vector<glm::vec2> circle(n + 1);
+	glm::vec2* circlePoints = &circle[0];
+	JobSystem::ParallelFor(n + 1, PRISM_SEGMENTS_PER_JOB, [n, circlePoints](size_t begin, size_t end)
+	{
+		ComputePrismCircle(n, begin, end, circlePoints);
+	});
+
+	// Every segment owns fixed slices of the vertices and indices, so slices are filled in parallel
+	verticies.resize(GetPrismVerticiesCount(n));
+	indices.resize(GetPrismIndicesCount(n));
+	Vertex* side = &verticies[0];
+	Vertex* top = side + n * PRISM_SIDE_VERTICIES;
+	Vertex* bottom = top + 1 + n * PRISM_BASE_VERTICIES;
+	TIndex* indicesData = &indices[0];
+	JobSystem::ParallelFor(n, PRISM_SEGMENTS_PER_JOB, [=](size_t begin, size_t end)
+	{
+		AddPrismSideFaces(n, circlePoints, begin, end, side);
+		AddPrismBase(n, PrismBaseType::Top, circlePoints, begin, end, top);
+		AddPrismBase(n, PrismBaseType::Bottom, circlePoints, begin, end, bottom);
+		AddPrismIndices(n, begin, end, indicesData);
+	});
+}
 
-	glm::vec3 previousTopPoint = glm::vec3{ radius * cos(startT), halfHeight, radius * sin(startT) };
-	glm::vec3 previousBottomPoint = glm::vec3{ radius * cos(startT), -halfHeight, radius * sin(startT) };
+void Mesh::GeneratePrism(size_t n, std::vector<Vertex>& verticies, std::vector<uint16_t>& indices)
+{
+	if (GetPrismVerticiesCount(n) > IndexBuffer::MAX_SHORT_VERTICIES)
+	{
+		throw std::runtime_error("Too many verticies for 16-bit indices");
+	}
 
-	glm::vec2 previousTopUV = glm::vec2{ 0.0f, 0.5f };
-	glm::vec2 previousBottomUV = glm::vec2{ 0.0f, 0.0f };
+	GeneratePrismIndexed(n, verticies, indices);
+}
 
-	const glm::vec2 uvStep = { 1.0f / n, 0.0f };
+void Mesh::GeneratePrism(size_t n, std::vector<Vertex>& verticies, std::vector<uint32_t>& indices)
+{
+	GeneratePrismIndexed(n, verticies, indices);
+}
 
-	for (size_t i = 0; i < n; i++)
-	{
-		const size_t k = (i + 1) % n;
-		const float t = 2 * PI * k / n + startT;
+RenderQueue::Geometry Mesh::GetGeometry() const
+{
+	return geometry->GetElementsGeometry(GL_TRIANGLES);
+}
 
-		const glm::vec2 coords{ radius * cos(t), radius * sin(t) };
-		const glm::vec3 topPoint = glm::vec3{ coords[0], halfHeight, coords[1] };
-		const glm::vec3 bottomPoint = glm::vec3{ coords[0], -halfHeight, coords[1] };
+RenderQueue::Geometry Mesh::GetNormalsGeometry() const
+{
+	return geometry->GetArraysGeometry(GL_POINTS);
+}
 
-		const glm::vec2 topUV = previousTopUV + uvStep;
-		const glm::vec2 bottomUV = previousBottomUV + uvStep;
+BufferLayout Mesh::GetLayout(VertexFormat format)
+{
+	std::vector<BufferElement> bufferElements;
+	if (format == VertexFormat::Compact)
+	{
+		bufferElements.push_back(BufferElement(BufferElement::Type::Half4, "a_Position", false));
+		bufferElements.push_back(BufferElement(BufferElement::Type::Packed1010102N, "a_Normal", true));
+		bufferElements.push_back(BufferElement(BufferElement::Type::UShort2N, "a_TexCoords", true));
+	}
+	else
+	{
+		bufferElements.push_back(BufferElement(BufferElement::Type::Float3, "a_Position", false));
+		bufferElements.push_back(BufferElement(BufferElement::Type::Float3, "a_Normal", false));
+		bufferElements.push_back(BufferElement(BufferElement::Type::Float2, "a_TexCoords", false));
+	}
 
-		const glm::vec3 normal = glm::normalize(glm::cross(
-			previousTopPoint - previousBottomPoint,
-			bottomPoint - previousBottomPoint
-		));
+	return BufferLayout(bufferElements);
+}
 
-		mesh.verticies.push_back(Vertex{ previousBottomPoint, normal, previousBottomUV });
-		mesh.verticies.push_back(Vertex{ previousTopPoint, normal, previousTopUV });
-		mesh.verticies.push_back(Vertex{ bottomPoint, normal, bottomUV });
+GeometryArena& Mesh::GetArena(VertexFormat format)
+{
+	std::shared_ptr<GeometryArena>& arena = arenas[format == VertexFormat::Compact ? 1 : 0];
+	if (!arena)
+	{
+		arena = std::make_shared<GeometryArena>(GetLayout(format));
+	}
 
-		mesh.verticies.push_back(Vertex{ bottomPoint, normal, bottomUV });
-		mesh.verticies.push_back(Vertex{ previousTopPoint, normal, previousTopUV });
-		mesh.verticies.push_back(Vertex{ topPoint, normal, topUV });
+	return *arena;
+}
 
-		previousTopPoint = topPoint;
-		previousBottomPoint = bottomPoint;
+void Mesh::ReleaseSharedObjects()
+{
+	arenas[0] = nullptr;
+	arenas[1] = nullptr;
+	emptyVertexArray = nullptr;
+}
 
-		previousTopUV = topUV;
-		previousBottomUV = bottomUV;
+RenderQueue::Geometry Mesh::GetProceduralPrismGeometry(size_t n, unsigned int mode)
+{
+	if (!emptyVertexArray)
+	{
+		emptyVertexArray = std::make_shared<VertexArray>();
 	}
+
+	return RenderQueue::Geometry{ emptyVertexArray->GetId(), mode, 0, 0, GetPrismIndicesCount(n), 0, 0, 0, 0, 0 };
 }
 
-void Mesh::ComputeNormals(const glm::vec3& scale)
+glm::vec2 Mesh::GetProceduralCirclePoint(size_t n, size_t i)
 {
-	if (this->scale == scale)
+	const float t = 2.0f * PI / float(n) * float(i % n) + PRISM_START_T;
+	return glm::vec2{ std::cos(t), std::sin(t) };
+}
+
+Vertex Mesh::GetProceduralPrismVertex(size_t n, size_t index)
+{
+	static const size_t SIDE_CORNERS[PRISM_SIDE_INDICES] = { 0, 1, 2, 2, 1, 3 };
+
+	Vertex vertex;
+	if (index < n * PRISM_SIDE_INDICES)
 	{
-		return;
+		const size_t segment = index / PRISM_SIDE_INDICES;
+		const size_t corner = SIDE_CORNERS[index % PRISM_SIDE_INDICES];
+		const glm::vec2 previousPoint = GetProceduralCirclePoint(n, segment);
+		const glm::vec2 nextPoint = GetProceduralCirclePoint(n, segment + 1);
+		const glm::vec2 previous = PRISM_RADIUS * previousPoint;
+		const glm::vec2 next = PRISM_RADIUS * nextPoint;
+		const glm::vec2 bisector = previousPoint + nextPoint;
+		vertex.normal = glm::normalize(glm::vec3{ bisector[0], 0.0f, bisector[1] });
+
+		const bool top = corner == 1 || corner == 3;
+		const size_t point = corner < 2 ? segment : segment + 1;
+		const glm::vec2 rim = corner < 2 ? previous : next;
+		vertex.position = glm::vec3{ rim[0], top ? PRISM_HEIGHT / 2.0f : -PRISM_HEIGHT / 2.0f, rim[1] };
+		vertex.uv = glm::vec2{ float(point) / float(n), top ? 0.5f : 0.0f };
+		return vertex;
 	}
 
-	size_t stride = normalsBuffer->GetLayout().GetStride();
-	float* coords = new float[stride * verticies.size() * 2];
-	for (size_t i = 0, offset = 0; i < verticies.size(); i++)
+	index -= n * PRISM_SIDE_INDICES;
+	const bool top = index < n * PRISM_BASE_INDICES;
+	if (!top)
 	{
-		const Vertex& vertex = verticies[i];
-		glm::vec3 end = vertex.position + vertex.normal * 0.4f / scale;
-		coords[offset++] = vertex.position[0];
-		coords[offset++] = vertex.position[1];
-		coords[offset++] = vertex.position[2];
+		index -= n * PRISM_BASE_INDICES;
+	}
 
-		coords[offset++] = end[0];
-		coords[offset++] = end[1];
-		coords[offset++] = end[2];
+	const size_t segment = index / PRISM_BASE_INDICES;
+	const size_t corner = index % PRISM_BASE_INDICES;
+	const float y = top ? PRISM_HEIGHT / 2.0f : -PRISM_HEIGHT / 2.0f;
+	const glm::vec2 centerUV = top ? glm::vec2{ 0.25f, 0.75f } : glm::vec2{ 0.75f, 0.75f };
+	vertex.normal = glm::vec3{ 0.0f, top ? 1.0f : -1.0f, 0.0f };
+	if (corner == 0)
+	{
+		vertex.position = glm::vec3{ 0.0f, y, 0.0f };
+		vertex.uv = centerUV;
+		return vertex;
 	}
 
-	normalsBuffer->SetData(coords, stride * verticies.size() * 2);
-	delete[] coords;
+	const glm::vec2 point = GetProceduralCirclePoint(n, corner == 1 ? segment + 1 : segment);
+	vertex.position = glm::vec3{ PRISM_RADIUS * point[0], y, PRISM_RADIUS * point[1] };
+	vertex.uv = 0.25f * point + centerUV;
+	return vertex;
 }
 
-void Mesh::Draw() const
+float Mesh::ValidateProceduralPrism(size_t n)
 {
-	vertexArray->Bind();
-	glDrawArrays(GL_TRIANGLES, 0, verticies.size());
+	std::vector<Vertex> verticies;
+	std::vector<uint32_t> indices;
+	GeneratePrism(n, verticies, indices);
+
+	float error = 0.0f;
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		const Vertex expected = verticies[indices[i]];
+		const Vertex actual = GetProceduralPrismVertex(n, i);
+		for (size_t j = 0; j < 3; j++)
+		{
+			error = std::max(error, std::abs(expected.position[j] - actual.position[j]));
+			error = std::max(error, std::abs(expected.normal[j] - actual.normal[j]));
+		}
+
+		for (size_t j = 0; j < 2; j++)
+		{
+			error = std::max(error, std::abs(expected.uv[j] - actual.uv[j]));
+		}
+	}
+
+	return error;
 }
 
-void Mesh::DrawNormals(const glm::vec3& scale)
+void Mesh::GeneratePrism(size_t n, VertexFormat format, PrismData& data)
 {
-	ComputeNormals(scale);
-	normalsVertexArray->Bind();
-	glDrawArrays(GL_LINES, 0, verticies.size() * 2);
+	// 16-bit indices halve the index memory whenever the vertex count allows
+	if (GetPrismVerticiesCount(n) <= IndexBuffer::MAX_SHORT_VERTICIES)
+	{
+		GeneratePrism(n, data.verticies, data.shortIndices);
+	}
+	else
+	{
+		GeneratePrism(n, data.verticies, data.indices);
+	}
+
+	if (format == VertexFormat::Compact && !data.verticies.empty())
+	{
+		data.compactVerticies.resize(data.verticies.size());
+		const Vertex* source = &data.verticies[0];
+		CompactVertex* destination = &data.compactVerticies[0];
+		JobSystem::ParallelFor(data.verticies.size(), PRISM_SEGMENTS_PER_JOB * 8, [source, destination](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				destination[i] = CompactVertex::Pack(source[i]);
+			}
+		});
+
+		// Only the packed vertices are uploaded
+		std::vector<Vertex>().swap(data.verticies);
+	}
 }
 
-Mesh Mesh::Prism(size_t n)
+Mesh Mesh::CreatePrism(VertexFormat format, PrismData& data)
 {
 	Mesh mesh;
-	if (n < 3)
+	mesh.vertexFormat = format;
+	const size_t verticiesCount = format == VertexFormat::Compact ? data.compactVerticies.size() : data.verticies.size();
+	if (verticiesCount == 0)
 	{
 		return mesh;
 	}
 
-	AddPrismSideFaces(n, mesh);
-	AddPrismBase(n, PrismBaseType::Top, mesh);
-	AddPrismBase(n, PrismBaseType::Bottom, mesh);
+	GeometryArena& arena = GetArena(format);
+	if (!data.shortIndices.empty())
+	{
+		mesh.geometry = arena.Reserve(verticiesCount, data.shortIndices.size(), GL_UNSIGNED_SHORT);
+	}
+	else
+	{
+		mesh.geometry = arena.Reserve(verticiesCount, data.indices.size(), GL_UNSIGNED_INT);
+	}
+
+	return mesh;
+}
 
-	mesh.vertexArray = std::make_shared<VertexArray>();
-	mesh.normalsVertexArray = std::make_shared<VertexArray>();
+size_t Mesh::Upload(const PrismData& data, size_t uploaded, size_t maxBytes)
+{
+	if (!geometry)
+	{
+		return uploaded;
+	}
 
-	std::vector<BufferElement> bufferElements;
-	bufferElements.push_back(BufferElement(BufferElement::Type::Float3, "a_Position", false));
-	bufferElements.push_back(BufferElement(BufferElement::Type::Float3, "a_Normal", false));
-	bufferElements.push_back(BufferElement(BufferElement::Type::Float2, "a_TexCoords", false));
-	BufferLayout layout(bufferElements);
-
-	size_t stride = layout.GetStride();
-	mesh.buffer = std::make_shared<VertexBuffer>(&mesh.verticies[0], stride * mesh.verticies.size(), layout);
-	mesh.vertexArray->AddVertexBuffer(*mesh.buffer);
-
-	std::vector<BufferElement> normalsBufferElements;
-	normalsBufferElements.push_back(BufferElement(BufferElement::Type::Float3, "a_Position", false));
-	BufferLayout normalsLayout(normalsBufferElements);
-
-	stride = normalsLayout.GetStride();
-	mesh.normalsBuffer = std::make_shared<VertexBuffer>(stride * mesh.verticies.size() * 2, normalsLayout);
-	mesh.normalsVertexArray->AddVertexBuffer(*mesh.normalsBuffer);
+	const size_t stride = GetLayout(vertexFormat).GetStride();
+	const size_t vertexBytes = geometry->GetVerticiesCount() * stride;
+	const char* verticies = vertexFormat == VertexFormat::Compact
+		? (const char*)&data.compactVerticies[0]
+		: (const char*)&data.verticies[0];
+
+	// Whole vertices and indices only, at least one of them per call
+	if (uploaded < vertexBytes)
+	{
+		const size_t first = uploaded / stride;
+		const size_t count = std::min(std::max<size_t>(maxBytes / stride, 1), geometry->GetVerticiesCount() - first);
+		geometry->WriteVerticies(first, count, verticies + first * stride);
+		return uploaded + count * stride;
+	}
+
+	const bool shortIndices = !data.shortIndices.empty();
+	const size_t indexSize = shortIndices ? sizeof(uint16_t) : sizeof(uint32_t);
+	const char* indices = shortIndices ? (const char*)&data.shortIndices[0] : (const char*)&data.indices[0];
+	const size_t first = (uploaded - vertexBytes) / indexSize;
+	if (first >= geometry->GetIndicesCount())
+	{
+		return uploaded;
+	}
+
+	const size_t count = std::min(std::max<size_t>(maxBytes / indexSize, 1), geometry->GetIndicesCount() - first);
+	geometry->WriteIndices(first, count, indices + first * indexSize);
+	return uploaded + count * indexSize;
+}
+
+Mesh Mesh::Prism(size_t n, VertexFormat format)
+{
+	if (n < 3)
+	{
+		Mesh mesh;
+		mesh.vertexFormat = format;
+		return mesh;
+	}
+
+	PrismData data;
+	GeneratePrism(n, format, data);
+	Mesh mesh = CreatePrism(format, data);
+	const size_t size = mesh.GetBuffersSize();
+	size_t uploaded = 0;
+	while (uploaded < size)
+	{
+		uploaded = mesh.Upload(data, uploaded, size);
+	}
 
 	return mesh;
 }
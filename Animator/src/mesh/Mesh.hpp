@@ -2,12 +2,14 @@
 
 #include <vector>
 #include <memory>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 #include "Vertex.hpp"
+#include "CompactVertex.hpp"
 #include "../MathConstants.hpp"
-#include "../renderer/VertexBuffer.hpp"
-#include "../renderer/VertexArray.hpp"
+#include "../renderer/BufferLayout.hpp"
+#include "../renderer/GeometryArena.hpp"
 
 const float PRISM_START_T = -3.0f * PI / 4.0f;
 const float PRISM_HEIGHT = 0.5f;
@@ -15,6 +17,26 @@ const float PRISM_RADIUS = sqrt(0.5f) / 2;
 
 class Mesh
 {
+public:
+	enum class VertexFormat
+	{
+		// 32 bytes of floats per vertex
+		Full,
+		// 16 bytes per vertex, see CompactVertex
+		Compact
+	};
+
+	// CPU side of a prism, generated without GL so it can be built on a worker thread
+	struct PrismData
+	{
+		// Emptied once packed into compactVerticies for VertexFormat::Compact
+		std::vector<Vertex> verticies;
+		// Only for VertexFormat::Compact
+		std::vector<CompactVertex> compactVerticies;
+		// 16-bit when the vertex count allows, the other one stays empty
+		std::vector<uint16_t> shortIndices;
+		std::vector<uint32_t> indices;
+	};
 private:
 	enum class PrismBaseType
 	{
@@ -22,28 +44,100 @@ private:
 		Top
 	};
 
-	static void AddPrismBase(size_t n, PrismBaseType type, Mesh& mesh);
+	// Per segment; each base also has its center vertex
+	static const size_t PRISM_SIDE_VERTICIES = 4;
+	static const size_t PRISM_BASE_VERTICIES = 1;
+	static const size_t PRISM_SIDE_INDICES = 6;
+	static const size_t PRISM_BASE_INDICES = 3;
+	static const size_t PRISM_SEGMENTS_PER_JOB = 256;
 
-	static void AddPrismSideFaces(size_t n, Mesh& mesh);
+	// One per vertex format, shared by all meshes of that format
+	static std::shared_ptr<GeometryArena> arenas[2];
 
-	std::vector<Vertex> verticies;
-	std::shared_ptr<VertexBuffer> buffer;
-	std::shared_ptr<VertexArray> vertexArray;
+	// Procedural prisms read no attributes
+	static std::shared_ptr<VertexArray> emptyVertexArray;
 
-	std::shared_ptr<VertexBuffer> normalsBuffer;
-	std::shared_ptr<VertexArray> normalsVertexArray;
+	static glm::vec2 GetProceduralCirclePoint(size_t n, size_t i);
 
-	glm::vec3 scale;
+	static void ComputePrismCircle(size_t n, size_t begin, size_t end, glm::vec2* circle);
+
+	// Write the vertices of segments [begin; end) into their slices
+	static void AddPrismBase(
+		size_t n,
+		PrismBaseType type,
+		const glm::vec2* circle,
+		size_t begin,
+		size_t end,
+		Vertex* verticies
+	);
+
+	static void AddPrismSideFaces(size_t n, const glm::vec2* circle, size_t begin, size_t end, Vertex* verticies);
+
+	template<typename TIndex>
+	static void AddPrismIndices(size_t n, size_t begin, size_t end, TIndex* indices);
+
+	template<typename TIndex>
+	static void GeneratePrismIndexed(size_t n, std::vector<Vertex>& verticies, std::vector<TIndex>& indices);
+
+	VertexFormat vertexFormat = VertexFormat::Full;
+	std::shared_ptr<GeometryArena::Allocation> geometry;
 
-	void ComputeNormals(const glm::vec3& scale);
 public:
 
-	const std::vector<Vertex>& GetVerticies() const { return verticies; }
+	size_t GetVerticiesCount() const { return geometry->GetVerticiesCount(); }
+	size_t GetIndicesCount() const { return geometry->GetIndicesCount(); }
+	VertexFormat GetVertexFormat() const { return vertexFormat; }
+
+	// Bytes taken in the arena buffers
+	size_t GetBuffersSize() const { return geometry->GetSize(); }
+
+	RenderQueue::Geometry GetGeometry() const;
+
+	// One point per vertex, expanded into a normal line by the normals geometry shader
+	RenderQueue::Geometry GetNormalsGeometry() const;
+
+	// For multi-draws of meshes sharing the arena of GetGeometry
+	RenderQueue::IndirectCommand GetIndirectCommand(uint32_t baseInstance = 0) const { return geometry->GetIndirectCommand(baseInstance); }
+
+	static size_t GetPrismVerticiesCount(size_t n) { return n < 3 ? 0 : n * (PRISM_SIDE_VERTICIES + 2 * PRISM_BASE_VERTICIES) + 2; }
+	static size_t GetPrismIndicesCount(size_t n) { return n < 3 ? 0 : n * (PRISM_SIDE_INDICES + 2 * PRISM_BASE_INDICES); }
+
+	// Vertices and indices of a prism with n sides, generated without touching GL
+	static void GeneratePrism(size_t n, std::vector<Vertex>& verticies, std::vector<uint16_t>& indices);
+	static void GeneratePrism(size_t n, std::vector<Vertex>& verticies, std::vector<uint32_t>& indices);
+
+	static void GeneratePrism(size_t n, VertexFormat format, PrismData& data);
+
+	// Reserves the arena ranges for the data. The ranges are filled by Upload,
+	// so the data must outlive the upload, no CPU copy is kept after it
+	static Mesh CreatePrism(VertexFormat format, PrismData& data);
+
+	// Writes at most maxBytes of the vertex data followed by the index data,
+	// resuming after the uploaded bytes. Returns the bytes uploaded so far,
+	// the upload is complete at GetBuffersSize()
+	size_t Upload(const PrismData& data, size_t uploaded, size_t maxBytes);
+
+	static Mesh Prism(size_t n, VertexFormat format = VertexFormat::Full);
+
+	static BufferLayout GetLayout(VertexFormat format);
+
+	// Created on first use, must be called with a GL context
+	static GeometryArena& GetArena(VertexFormat format);
+
+	// Drops the arenas and the empty vertex array, the arenas go away with
+	// their last mesh. Must be called while the GL context is alive
+	static void ReleaseSharedObjects();
 
-	void Draw() const;
+	// Non-indexed, 12 * n vertices from gl_VertexID alone. The bound program must
+	// be linked with Prism.vert.glsl and have u_PrismN set to n
+	static RenderQueue::Geometry GetProceduralPrismGeometry(size_t n, unsigned int mode);
 
-	void DrawNormals(const glm::vec3& scale);
+	// CPU twin of LoadVertex in Prism.vert.glsl: vertex index of the prism
+	// drawn with GetProceduralPrismGeometry, the same float math as the shader
+	static Vertex GetProceduralPrismVertex(size_t n, size_t index);
 
-	static Mesh Prism(size_t n);
+	// Largest difference between the procedural vertices and the indexed
+	// vertices of GeneratePrism, over positions, normals and UVs
+	static float ValidateProceduralPrism(size_t n);
 };
 
@@ -0,0 +1,149 @@
+#include "PrismBuilder.hpp"
+
+#include "PrismCache.hpp"
+#include "../Debug.hpp"
+
+bool PrismBuilder::requested = false;
+size_t PrismBuilder::requestedN = 0;
+Mesh::VertexFormat PrismBuilder::requestedFormat = Mesh::VertexFormat::Full;
+std::unique_ptr<PrismBuilder::Build> PrismBuilder::build;
+
+size_t PrismBuilder::started = 0;
+size_t PrismBuilder::skipped = 0;
+size_t PrismBuilder::completed = 0;
+
+void PrismBuilder::Start()
+{
+	const size_t n = requestedN;
+	const Mesh::VertexFormat format = requestedFormat;
+	std::shared_ptr<Mesh::PrismData> data = std::make_shared<Mesh::PrismData>();
+
+	build.reset(new Build());
+	build->n = n;
+	build->format = format;
+	build->data = data;
+	build->job = JobSystem::Run([n, format, data]()
+	{
+		Mesh::GeneratePrism(n, format, *data);
+	});
+
+	started++;
+}
+
+void PrismBuilder::Request(size_t n, Mesh::VertexFormat format)
+{
+	if (requested && requestedN == n && requestedFormat == format)
+	{
+		return;
+	}
+
+	if (requested)
+	{
+		skipped++;
+	}
+
+	requested = true;
+	requestedN = n;
+	requestedFormat = format;
+	if (build == nullptr)
+	{
+		Start();
+	}
+}
+
+void PrismBuilder::Cancel()
+{
+	if (requested)
+	{
+		skipped++;
+	}
+
+	requested = false;
+}
+
+std::shared_ptr<Mesh> PrismBuilder::Update()
+{
+	if (build == nullptr || !build->job->IsFinished())
+	{
+		return nullptr;
+	}
+
+	try
+	{
+		JobSystem::Wait(build->job);
+	}
+	catch (const std::exception& error)
+	{
+		// E.g. out of memory for a huge N, the current prism stays
+		Debug::LogFormat(Debug::MessageType::Error, "Failed to build prism. N - %zu, reason - %s", build->n, error.what());
+		const bool superseded = build->n != requestedN || build->format != requestedFormat;
+		build = nullptr;
+		if (requested && superseded)
+		{
+			// A newer request arrived while the failed one was built
+			Start();
+		}
+		else
+		{
+			requested = false;
+		}
+
+		return nullptr;
+	}
+
+	if (!requested || build->n != requestedN || build->format != requestedFormat)
+	{
+		// Superseded while it was built, the reserved ranges go back to the arena
+		build = nullptr;
+		if (requested)
+		{
+			Start();
+		}
+
+		return nullptr;
+	}
+
+	if (build->mesh == nullptr)
+	{
+		build->mesh = std::make_shared<Mesh>(Mesh::CreatePrism(build->format, *build->data));
+	}
+
+	build->uploaded = build->mesh->Upload(*build->data, build->uploaded, UPLOAD_BUDGET);
+	if (build->uploaded < build->mesh->GetBuffersSize())
+	{
+		return nullptr;
+	}
+
+	std::shared_ptr<Mesh> mesh = build->mesh;
+	PrismCache::Add(build->n, build->format, mesh);
+	build = nullptr;
+	requested = false;
+	completed++;
+	return mesh;
+}
+
+void PrismBuilder::ResetStatistics()
+{
+	started = 0;
+	skipped = 0;
+	completed = 0;
+}
+
+void PrismBuilder::Clear()
+{
+	if (build != nullptr)
+	{
+		try
+		{
+			JobSystem::Wait(build->job);
+		}
+		catch (const std::exception&)
+		{
+			// Dropped with the build
+		}
+
+		build = nullptr;
+	}
+
+	requested = false;
+}
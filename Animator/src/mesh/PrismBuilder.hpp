@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+
+#include "Mesh.hpp"
+#include "../jobs/JobSystem.hpp"
+
+// Builds prisms outside the frame: the vertices are generated by a job, then
+// the data is uploaded on the GL thread at most UPLOAD_BUDGET bytes per Update,
+// so the caller keeps drawing its current prism until the new one is complete.
+// One build runs at a time and only the latest request is kept, values
+// requested while a build runs are skipped except the last one
+class PrismBuilder
+{
+private:
+	struct Build
+	{
+		size_t n;
+		Mesh::VertexFormat format;
+		std::shared_ptr<Mesh::PrismData> data;
+		JobSystem::JobHandle job;
+		std::shared_ptr<Mesh> mesh;
+		size_t uploaded = 0;
+	};
+
+	static bool requested;
+	static size_t requestedN;
+	static Mesh::VertexFormat requestedFormat;
+	static std::unique_ptr<Build> build;
+
+	static size_t started;
+	static size_t skipped;
+	static size_t completed;
+
+	static void Start();
+public:
+	static const size_t UPLOAD_BUDGET = 8 * 1024 * 1024;
+
+	static void Request(size_t n, Mesh::VertexFormat format);
+
+	// Forgets the request, e.g. when the wanted prism is already cached
+	static void Cancel();
+
+	// Called once per frame on the GL thread. Returns the requested prism
+	// when it is complete, it is also added to PrismCache
+	static std::shared_ptr<Mesh> Update();
+
+	static bool IsBuilding() { return build != nullptr; }
+
+	static size_t GetStarted() { return started; }
+	static size_t GetSkipped() { return skipped; }
+	static size_t GetCompleted() { return completed; }
+
+	static void ResetStatistics();
+
+	// Waits for the running job. Must be called while the GL context and the job system are alive
+	static void Clear();
+};
@@ -0,0 +1,85 @@
+#include "PrismCache.hpp"
+
+std::list<PrismCache::Entry> PrismCache::entries;
+std::unordered_map<size_t, std::list<PrismCache::Entry>::iterator> PrismCache::index;
+size_t PrismCache::capacity = PrismCache::DEFAULT_CAPACITY;
+size_t PrismCache::size = 0;
+
+size_t PrismCache::hits = 0;
+size_t PrismCache::misses = 0;
+size_t PrismCache::evictions = 0;
+
+void PrismCache::Evict()
+{
+	// The most recent entry stays even if it alone exceeds the capacity
+	while (size > capacity && entries.size() > 1)
+	{
+		const Entry& entry = entries.back();
+		size -= entry.size;
+		index.erase(entry.key);
+		entries.pop_back();
+		evictions++;
+	}
+}
+
+std::shared_ptr<Mesh> PrismCache::Get(size_t n, Mesh::VertexFormat format)
+{
+	std::shared_ptr<Mesh> mesh = Find(n, format);
+	if (mesh == nullptr)
+	{
+		mesh = std::make_shared<Mesh>(Mesh::Prism(n, format));
+		Add(n, format, mesh);
+	}
+
+	return mesh;
+}
+
+std::shared_ptr<Mesh> PrismCache::Find(size_t n, Mesh::VertexFormat format)
+{
+	auto iterator = index.find(GetKey(n, format));
+	if (iterator == index.end())
+	{
+		misses++;
+		return nullptr;
+	}
+
+	hits++;
+	entries.splice(entries.begin(), entries, iterator->second);
+	return entries.front().mesh;
+}
+
+void PrismCache::Add(size_t n, Mesh::VertexFormat format, const std::shared_ptr<Mesh>& mesh)
+{
+	const size_t key = GetKey(n, format);
+	auto iterator = index.find(key);
+	if (iterator != index.end())
+	{
+		size -= iterator->second->size;
+		entries.erase(iterator->second);
+	}
+
+	entries.push_front(Entry{ key, mesh, mesh->GetBuffersSize() });
+	index[key] = entries.begin();
+	size += entries.front().size;
+	Evict();
+}
+
+void PrismCache::SetCapacity(size_t bytes)
+{
+	capacity = bytes;
+	Evict();
+}
+
+void PrismCache::ResetStatistics()
+{
+	hits = 0;
+	misses = 0;
+	evictions = 0;
+}
+
+void PrismCache::Clear()
+{
+	entries.clear();
+	index.clear();
+	size = 0;
+}
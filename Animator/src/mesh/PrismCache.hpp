@@ -0,0 +1,55 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "Mesh.hpp"
+
+// Keeps recently used prisms so returning to a side count and vertex format does not
+// rebuild and upload the mesh again. Entries are evicted least recently
+// used first once their buffers exceed the capacity
+class PrismCache
+{
+private:
+	struct Entry
+	{
+		size_t key;
+		std::shared_ptr<Mesh> mesh;
+		size_t size;
+	};
+
+	static std::list<Entry> entries;
+	static std::unordered_map<size_t, std::list<Entry>::iterator> index;
+	static size_t capacity;
+	static size_t size;
+
+	static size_t hits;
+	static size_t misses;
+	static size_t evictions;
+
+	static void Evict();
+	static size_t GetKey(size_t n, Mesh::VertexFormat format) { return n * 2 + (format == Mesh::VertexFormat::Compact ? 1 : 0); }
+public:
+	static const size_t DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+	static std::shared_ptr<Mesh> Get(size_t n, Mesh::VertexFormat format = Mesh::VertexFormat::Full);
+
+	// Null on a miss, does not build the mesh
+	static std::shared_ptr<Mesh> Find(size_t n, Mesh::VertexFormat format);
+	static void Add(size_t n, Mesh::VertexFormat format, const std::shared_ptr<Mesh>& mesh);
+
+	static void SetCapacity(size_t bytes);
+	static size_t GetCapacity() { return capacity; }
+	static size_t GetSize() { return size; }
+	static size_t GetMeshesCount() { return entries.size(); }
+
+	static size_t GetHits() { return hits; }
+	static size_t GetMisses() { return misses; }
+	static size_t GetEvictions() { return evictions; }
+
+	static void ResetStatistics();
+
+	// Must be called while the GL context is alive
+	static void Clear();
+};
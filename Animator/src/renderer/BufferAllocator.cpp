@@ -0,0 +1,102 @@
+#include "BufferAllocator.hpp"
+
+#include <cassert>
+#include <iterator>
+#include <stdexcept>
+
+BufferAllocator::BufferAllocator(size_t capacity) : capacity(capacity)
+{
+	if (capacity > 0)
+	{
+		freeRanges[0] = capacity;
+	}
+}
+
+void BufferAllocator::AddFreeRange(size_t offset, size_t size)
+{
+	auto next = freeRanges.lower_bound(offset);
+	if (next != freeRanges.end() && offset + size == next->first)
+	{
+		size += next->second;
+		next = freeRanges.erase(next);
+	}
+
+	if (next != freeRanges.begin())
+	{
+		auto previous = std::prev(next);
+		if (previous->first + previous->second == offset)
+		{
+			previous->second += size;
+			return;
+		}
+	}
+
+	freeRanges.emplace_hint(next, offset, size);
+}
+
+size_t BufferAllocator::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0)
+	{
+		throw std::runtime_error("Empty allocation");
+	}
+
+	if (alignment == 0)
+	{
+		alignment = 1;
+	}
+
+	for (auto iterator = freeRanges.begin(); iterator != freeRanges.end(); iterator++)
+	{
+		const size_t rangeOffset = iterator->first;
+		const size_t rangeEnd = rangeOffset + iterator->second;
+		const size_t offset = (rangeOffset + alignment - 1) / alignment * alignment;
+		if (offset + size > rangeEnd)
+		{
+			continue;
+		}
+
+		// The remainders lie inside the taken range, so they have no free neighbours
+		freeRanges.erase(iterator);
+		if (offset > rangeOffset)
+		{
+			freeRanges[rangeOffset] = offset - rangeOffset;
+		}
+
+		if (offset + size < rangeEnd)
+		{
+			freeRanges[offset + size] = rangeEnd - offset - size;
+		}
+
+		allocations[offset] = size;
+		used += size;
+		return offset;
+	}
+
+	return INVALID_OFFSET;
+}
+
+void BufferAllocator::Free(size_t offset)
+{
+	auto iterator = allocations.find(offset);
+	assert(iterator != allocations.end() && "No allocation at the offset");
+	if (iterator == allocations.end())
+	{
+		return;
+	}
+
+	AddFreeRange(offset, iterator->second);
+	used -= iterator->second;
+	allocations.erase(iterator);
+}
+
+void BufferAllocator::Grow(size_t capacity)
+{
+	if (capacity <= this->capacity)
+	{
+		return;
+	}
+
+	AddFreeRange(this->capacity, capacity - this->capacity);
+	this->capacity = capacity;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Hands out ranges of a buffer first fit from a free list ordered by offset.
+// Freed ranges merge with their free neighbours, so the list only holds the
+// gaps between live ranges. Knows nothing about GL, sizes are in any unit
+class BufferAllocator
+{
+private:
+	size_t capacity;
+	size_t used = 0;
+
+	// Offset to size
+	std::map<size_t, size_t> freeRanges;
+	std::unordered_map<size_t, size_t> allocations;
+
+	void AddFreeRange(size_t offset, size_t size);
+public:
+	static const size_t INVALID_OFFSET = SIZE_MAX;
+
+	BufferAllocator(size_t capacity);
+
+	// The offset is a multiple of the alignment, which does not have to be
+	// a power of two. Returns INVALID_OFFSET when no free range fits
+	size_t Allocate(size_t size, size_t alignment);
+
+	// Does not throw, it runs in destructors. The offset must come from Allocate
+	void Free(size_t offset);
+
+	// Appends free space at the end, live ranges keep their offsets
+	void Grow(size_t capacity);
+
+	size_t GetCapacity() const { return capacity; }
+	size_t GetUsed() const { return used; }
+	size_t GetAllocationsCount() const { return allocations.size(); }
+	size_t GetFreeRangesCount() const { return freeRanges.size(); }
+};
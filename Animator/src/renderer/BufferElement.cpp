@@ -1,5 +1,6 @@
 #include "BufferElement.hpp"
 
+#include <cstdint>
 #include <stdexcept>
 
 size_t BufferElement::TypeToSize(BufferElement::Type type)
@@ -28,6 +29,24 @@ size_t BufferElement::TypeToSize(BufferElement::Type type)
 		return sizeof(float) * 3 * 3;
 	case BufferElement::Type::Mat4:
 		return sizeof(float) * 4 * 4;
+	case BufferElement::Type::Half2:
+		return sizeof(uint16_t) * 2;
+	case BufferElement::Type::Half4:
+		return sizeof(uint16_t) * 4;
+	case BufferElement::Type::Short2N:
+		return sizeof(int16_t) * 2;
+	case BufferElement::Type::Short4N:
+		return sizeof(int16_t) * 4;
+	case BufferElement::Type::UShort2N:
+		return sizeof(uint16_t) * 2;
+	case BufferElement::Type::Byte4N:
+		return sizeof(int8_t) * 4;
+	case BufferElement::Type::UByte4N:
+		return sizeof(uint8_t) * 4;
+	case BufferElement::Type::Packed1010102N:
+		return sizeof(uint32_t);
+	case BufferElement::Type::Octahedral:
+		return sizeof(int16_t) * 2;
 	default:
 		throw std::runtime_error("Unknown element type");
 	}
@@ -59,7 +78,42 @@ size_t BufferElement::GetComponentCount() const
 		return 3;
 	case BufferElement::Type::Mat4:
 		return 4;
+	case BufferElement::Type::Half2:
+		return 2;
+	case BufferElement::Type::Half4:
+		return 4;
+	case BufferElement::Type::Short2N:
+		return 2;
+	case BufferElement::Type::Short4N:
+		return 4;
+	case BufferElement::Type::UShort2N:
+		return 2;
+	case BufferElement::Type::Byte4N:
+		return 4;
+	case BufferElement::Type::UByte4N:
+		return 4;
+	case BufferElement::Type::Packed1010102N:
+		return 4;
+	case BufferElement::Type::Octahedral:
+		return 2;
 	default:
 		throw std::runtime_error("Unknown element type");
 	}
 }
+
+bool BufferElement::IsNormalizedType(BufferElement::Type type)
+{
+	switch (type)
+	{
+	case BufferElement::Type::Short2N:
+	case BufferElement::Type::Short4N:
+	case BufferElement::Type::UShort2N:
+	case BufferElement::Type::Byte4N:
+	case BufferElement::Type::UByte4N:
+	case BufferElement::Type::Packed1010102N:
+	case BufferElement::Type::Octahedral:
+		return true;
+	default:
+		return false;
+	}
+}
@@ -18,9 +18,22 @@ public:
 		Float4,
 		Mat3,
 		Mat4,
+		// Compressed types, read by shaders as floats
+		Half2,
+		Half4,
+		Short2N,
+		Short4N,
+		UShort2N,
+		Byte4N,
+		UByte4N,
+		// Signed normalized x, y, z in 10 bits each and w in 2 bits
+		Packed1010102N,
+		// Unit vector folded onto an octahedron, two signed normalized shorts the shader decodes
+		Octahedral,
 	};
 
 	static size_t TypeToSize(BufferElement::Type type);
+	static bool IsNormalizedType(BufferElement::Type type);
 
 	BufferElement::Type type;
 	std::string name;
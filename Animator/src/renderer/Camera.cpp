@@ -34,6 +34,7 @@ void Camera::UpdateViewMatrix()
 void Camera::UpdateViewProjectionMatrix()
 {
 	viewProjectionMatrix = projectionMatrix * viewMatrix;
+	version = NextChangeVersion();
 }
 
 void Camera::Update(float deltaTime) { }
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include "CameraException.hpp"
+#include "../ChangeTracker.hpp"
 
 class Camera
 {
@@ -77,6 +78,9 @@ public:
 	const glm::mat4& ViewMatrix() const;
 	const glm::mat4& ViewProjectionMatrix() const;
 
+	// Changes whenever one of the matrices above changes
+	size_t GetVersion() const { return version; }
+
 private:
 	Projection projectionType;
 	glm::mat4 projectionMatrix;
@@ -86,6 +90,7 @@ private:
 	glm::mat4 viewProjectionMatrix;
 	size_t screenWidth;
 	size_t screenHeight;
+	size_t version = 0;
 
 	// Orthographic
 	size_t size = 5;
@@ -0,0 +1,152 @@
+#include "GeometryArena.hpp"
+
+#include <algorithm>
+#include <GL/glew.h>
+
+GeometryArena::Allocation::~Allocation()
+{
+	arena->verticies.allocator.Free(vertexOffset);
+	arena->indices.allocator.Free(indexOffset);
+}
+
+void GeometryArena::Allocation::WriteVerticies(size_t first, size_t count, const void* verticies)
+{
+	const size_t stride = arena->layout.GetStride();
+	glNamedBufferSubData(arena->verticies.buffer, vertexOffset + first * stride, count * stride, verticies);
+}
+
+void GeometryArena::Allocation::WriteIndices(size_t first, size_t count, const void* indices)
+{
+	glNamedBufferSubData(arena->indices.buffer, indexOffset + first * indexSize, count * indexSize, indices);
+}
+
+RenderQueue::Geometry GeometryArena::Allocation::GetElementsGeometry(unsigned int mode) const
+{
+	return RenderQueue::Geometry{
+		arena->vertexArray.GetId(),
+		mode,
+		indexType,
+		indexOffset,
+		indicesCount,
+		(int)GetBaseVertex(),
+		0,
+		0,
+		0,
+		0
+	};
+}
+
+RenderQueue::Geometry GeometryArena::Allocation::GetArraysGeometry(unsigned int mode) const
+{
+	return RenderQueue::Geometry{ arena->vertexArray.GetId(), mode, 0, 0, verticiesCount, (int)GetBaseVertex(), 0, 0, 0, 0 };
+}
+
+RenderQueue::IndirectCommand GeometryArena::Allocation::GetIndirectCommand(uint32_t baseInstance) const
+{
+	return RenderQueue::IndirectCommand{
+		(uint32_t)indicesCount,
+		1,
+		(uint32_t)(indexOffset / indexSize),
+		(int32_t)GetBaseVertex(),
+		baseInstance
+	};
+}
+
+unsigned int GeometryArena::CreateBuffer(size_t capacity)
+{
+	unsigned int buffer;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+	return buffer;
+}
+
+GeometryArena::GeometryArena(const BufferLayout& layout, size_t vertexCapacity, size_t indexCapacity)
+	: layout(layout), verticies(vertexCapacity), indices(indexCapacity)
+{
+	verticies.buffer = CreateBuffer(vertexCapacity);
+	indices.buffer = CreateBuffer(indexCapacity);
+	vertexArray.SetLayout(layout);
+	vertexArray.SetVertexBuffer(0, verticies.buffer, 0, layout.GetStride());
+	vertexArray.SetIndexBuffer(indices.buffer);
+}
+
+GeometryArena::~GeometryArena()
+{
+	glDeleteBuffers(1, &verticies.buffer);
+	glDeleteBuffers(1, &indices.buffer);
+}
+
+size_t GeometryArena::Reserve(Pool& pool, size_t size, size_t alignment)
+{
+	size_t offset = pool.allocator.Allocate(size, alignment);
+	if (offset == BufferAllocator::INVALID_OFFSET)
+	{
+		// Doubling keeps the number of copies logarithmic in the final size
+		const size_t capacity = pool.allocator.GetCapacity();
+		const size_t newCapacity = std::max(capacity * 2, capacity + size + alignment);
+		const unsigned int buffer = CreateBuffer(newCapacity);
+		glCopyNamedBufferSubData(pool.buffer, buffer, 0, 0, capacity);
+		glDeleteBuffers(1, &pool.buffer);
+		pool.buffer = buffer;
+		pool.allocator.Grow(newCapacity);
+		growths++;
+
+		vertexArray.SetVertexBuffer(0, verticies.buffer, 0, layout.GetStride());
+		vertexArray.SetIndexBuffer(indices.buffer);
+		offset = pool.allocator.Allocate(size, alignment);
+	}
+
+	return offset;
+}
+
+std::shared_ptr<GeometryArena::Allocation> GeometryArena::Reserve(size_t verticiesCount, size_t indicesCount, unsigned int indexType)
+{
+	const size_t stride = layout.GetStride();
+	const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+	const size_t vertexOffset = Reserve(verticies, verticiesCount * stride, stride);
+	size_t indexOffset;
+	try
+	{
+		indexOffset = Reserve(indices, indicesCount * indexSize, indexSize);
+	}
+	catch (...)
+	{
+		verticies.allocator.Free(vertexOffset);
+		throw;
+	}
+
+	std::shared_ptr<Allocation> allocation(new Allocation(shared_from_this()));
+	allocation->vertexOffset = vertexOffset;
+	allocation->indexOffset = indexOffset;
+	allocation->verticiesCount = verticiesCount;
+	allocation->indicesCount = indicesCount;
+	allocation->indexType = indexType;
+	allocation->indexSize = indexSize;
+	return allocation;
+}
+
+std::shared_ptr<GeometryArena::Allocation> GeometryArena::Allocate(
+	const void* verticies,
+	size_t verticiesCount,
+	const uint16_t* indices,
+	size_t indicesCount
+)
+{
+	std::shared_ptr<Allocation> allocation = Reserve(verticiesCount, indicesCount, GL_UNSIGNED_SHORT);
+	allocation->WriteVerticies(0, verticiesCount, verticies);
+	allocation->WriteIndices(0, indicesCount, indices);
+	return allocation;
+}
+
+std::shared_ptr<GeometryArena::Allocation> GeometryArena::Allocate(
+	const void* verticies,
+	size_t verticiesCount,
+	const uint32_t* indices,
+	size_t indicesCount
+)
+{
+	std::shared_ptr<Allocation> allocation = Reserve(verticiesCount, indicesCount, GL_UNSIGNED_INT);
+	allocation->WriteVerticies(0, verticiesCount, verticies);
+	allocation->WriteIndices(0, indicesCount, indices);
+	return allocation;
+}
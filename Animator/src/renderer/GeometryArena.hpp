@@ -0,0 +1,110 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+
+#include "BufferLayout.hpp"
+#include "BufferAllocator.hpp"
+#include "VertexArray.hpp"
+#include "RenderQueue.hpp"
+
+// Vertices and indices of many meshes with one vertex layout, kept in one
+// vertex buffer and one index buffer and drawn through one vertex array.
+// A mesh is a base vertex plus an index range, so drawing different meshes
+// needs no rebinding. A buffer that runs out of space is replaced by a larger
+// copy, existing ranges keep their offsets
+class GeometryArena : public std::enable_shared_from_this<GeometryArena>
+{
+public:
+	// Frees its ranges when destroyed and keeps the arena alive until then
+	class Allocation
+	{
+		friend class GeometryArena;
+	private:
+		std::shared_ptr<GeometryArena> arena;
+		size_t vertexOffset;
+		size_t verticiesCount;
+		size_t indexOffset;
+		size_t indicesCount;
+		unsigned int indexType;
+		size_t indexSize;
+
+		Allocation(std::shared_ptr<GeometryArena> arena) : arena(arena) { }
+	public:
+		~Allocation();
+
+		Allocation(const Allocation&) = delete;
+		Allocation& operator=(const Allocation&) = delete;
+
+		size_t GetBaseVertex() const { return vertexOffset / arena->layout.GetStride(); }
+		size_t GetVerticiesCount() const { return verticiesCount; }
+		size_t GetIndicesCount() const { return indicesCount; }
+
+		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		unsigned int GetIndexType() const { return indexType; }
+
+		// Bytes taken in the arena buffers
+		size_t GetSize() const { return verticiesCount * arena->layout.GetStride() + indicesCount * indexSize; }
+
+		// Fill reserved ranges, first and count are in vertices and indices
+		void WriteVerticies(size_t first, size_t count, const void* verticies);
+		void WriteIndices(size_t first, size_t count, const void* indices);
+
+		// Indexed draw of the mesh and a non-indexed draw of its vertices for a RenderQueue item
+		RenderQueue::Geometry GetElementsGeometry(unsigned int mode) const;
+		RenderQueue::Geometry GetArraysGeometry(unsigned int mode) const;
+
+		// The indexed draw as one command of a multi-draw over the arena vertex array
+		RenderQueue::IndirectCommand GetIndirectCommand(uint32_t baseInstance) const;
+	};
+
+	static const size_t DEFAULT_VERTEX_CAPACITY = 4 * 1024 * 1024;
+	static const size_t DEFAULT_INDEX_CAPACITY = 2 * 1024 * 1024;
+private:
+	struct Pool
+	{
+		unsigned int buffer = 0;
+		BufferAllocator allocator;
+
+		Pool(size_t capacity) : allocator(capacity) { }
+	};
+
+	BufferLayout layout;
+	VertexArray vertexArray;
+	Pool verticies;
+	Pool indices;
+	size_t growths = 0;
+
+	static unsigned int CreateBuffer(size_t capacity);
+
+	size_t Reserve(Pool& pool, size_t size, size_t alignment);
+public:
+	GeometryArena(
+		const BufferLayout& layout,
+		size_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+		size_t indexCapacity = DEFAULT_INDEX_CAPACITY
+	);
+	~GeometryArena();
+
+	GeometryArena(const GeometryArena&) = delete;
+	GeometryArena& operator=(const GeometryArena&) = delete;
+
+	// The arena must be owned by a shared_ptr. Reserved ranges are undefined
+	// until written, so large meshes can be uploaded in parts over several frames
+	std::shared_ptr<Allocation> Reserve(size_t verticiesCount, size_t indicesCount, unsigned int indexType);
+
+	// Vertices are laid out as described by the arena layout
+	std::shared_ptr<Allocation> Allocate(const void* verticies, size_t verticiesCount, const uint16_t* indices, size_t indicesCount);
+	std::shared_ptr<Allocation> Allocate(const void* verticies, size_t verticiesCount, const uint32_t* indices, size_t indicesCount);
+
+	void Bind() const { vertexArray.Bind(); }
+
+	const BufferLayout& GetLayout() const { return layout; }
+
+	// In bytes
+	size_t GetCapacity() const { return verticies.allocator.GetCapacity() + indices.allocator.GetCapacity(); }
+	size_t GetUsed() const { return verticies.allocator.GetUsed() + indices.allocator.GetUsed(); }
+
+	size_t GetMeshesCount() const { return verticies.allocator.GetAllocationsCount(); }
+	size_t GetGrowths() const { return growths; }
+};
@@ -2,13 +2,22 @@
 
 #include <GL/glew.h>
 
-IndexBuffer::IndexBuffer(size_t* indices, size_t size)
+void IndexBuffer::Create(const void* indices, size_t size, size_t indexSize)
 {
 	this->size = size;
-	glGenBuffers(1, &buffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size * sizeof(size_t), indices, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	this->indexSize = indexSize;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferData(buffer, size * indexSize, indices, GL_STATIC_DRAW);
+}
+
+IndexBuffer::IndexBuffer(const uint16_t* indices, size_t size) : type(GL_UNSIGNED_SHORT)
+{
+	Create(indices, size, sizeof(uint16_t));
+}
+
+IndexBuffer::IndexBuffer(const uint32_t* indices, size_t size) : type(GL_UNSIGNED_INT)
+{
+	Create(indices, size, sizeof(uint32_t));
 }
 
 IndexBuffer::~IndexBuffer()
@@ -1,16 +1,33 @@
 #pragma once
 
+#include <cstdint>
+
 class IndexBuffer
 {
 private:
-	size_t buffer;
+	unsigned int buffer;
 	size_t size;
+	unsigned int type;
+	size_t indexSize;
+
+	void Create(const void* indices, size_t size, size_t indexSize);
 public:
-	IndexBuffer(size_t* indices, size_t size);
+	// 16-bit indices address at most this many vertices
+	static const size_t MAX_SHORT_VERTICIES = UINT16_MAX + 1;
+
+	IndexBuffer(const uint16_t* indices, size_t size);
+	IndexBuffer(const uint32_t* indices, size_t size);
 	~IndexBuffer();
 
 	void Bind() const;
 	void Unbind() const;
 
+	unsigned int GetId() const { return buffer; }
+
+	// Count of indices
 	size_t GetSize() const;
+
+	// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int GetType() const { return type; }
+	size_t GetIndexSize() const { return indexSize; }
 };
@@ -0,0 +1,159 @@
+#include "ProgramCache.hpp"
+
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <Windows.h>
+#include <GL/glew.h>
+
+#include "../Debug.hpp"
+
+std::string ProgramCache::directory;
+std::string ProgramCache::driver;
+bool ProgramCache::enabled = false;
+
+size_t ProgramCache::loads = 0;
+size_t ProgramCache::misses = 0;
+size_t ProgramCache::rejections = 0;
+
+// Written in front of the binary, a file of another layout is a miss
+const uint32_t FILE_MAGIC = 0x43425041;
+const uint32_t FILE_VERSION = 1;
+// Far above any real program, a larger length means a corrupt file
+const uint32_t MAX_BINARY_SIZE = 64 * 1024 * 1024;
+
+// 64-bit FNV-1a, stable across runs and compilers unlike std::hash
+static uint64_t Hash(uint64_t hash, const std::string& text)
+{
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+static std::string GetString(unsigned int name)
+{
+	const char* value = (const char*)glGetString(name);
+	return value == nullptr ? "" : value;
+}
+
+void ProgramCache::Initialize(const std::string& directory)
+{
+	int formatsCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsCount);
+	enabled = formatsCount > 0;
+	if (!enabled)
+	{
+		Debug::LogWarning("Program binaries are not supported, shaders are compiled on every launch");
+		return;
+	}
+
+	ProgramCache::directory = directory;
+	driver = GetString(GL_VENDOR) + "\n" + GetString(GL_RENDERER) + "\n" + GetString(GL_VERSION);
+	CreateDirectoryA(directory.c_str(), nullptr);
+}
+
+std::string ProgramCache::GetPath(uint64_t key)
+{
+	char name[32];
+	sprintf_s(name, "%016llx.bin", (unsigned long long)key);
+	return directory + "/" + name;
+}
+
+uint64_t ProgramCache::GetKey(const std::string& sources)
+{
+	return Hash(Hash(0xcbf29ce484222325ull, driver), sources);
+}
+
+bool ProgramCache::LoadBinary(unsigned int program, uint64_t key)
+{
+	std::ifstream file(GetPath(key), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	const std::streamoff fileSize = file.tellg();
+	file.seekg(0);
+	uint32_t header[4] = { };
+	file.read((char*)header, sizeof(header));
+	if (!file || header[0] != FILE_MAGIC || header[1] != FILE_VERSION)
+	{
+		return false;
+	}
+
+	// A truncated or corrupt file is a miss, the program is relinked and the file replaced
+	if (header[3] == 0 || header[3] > MAX_BINARY_SIZE || std::streamoff(header[3]) != fileSize - std::streamoff(sizeof(header)))
+	{
+		return false;
+	}
+
+	const unsigned int format = header[2];
+	std::vector<char> binary(header[3]);
+	file.read(binary.data(), binary.size());
+	if (!file)
+	{
+		return false;
+	}
+
+	glProgramBinary(program, format, binary.data(), (int)binary.size());
+	int status = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status)
+	{
+		rejections++;
+		return false;
+	}
+
+	return true;
+}
+
+bool ProgramCache::Load(unsigned int program, uint64_t key)
+{
+	if (!enabled)
+	{
+		return false;
+	}
+
+	if (!LoadBinary(program, key))
+	{
+		misses++;
+		return false;
+	}
+
+	loads++;
+	return true;
+}
+
+void ProgramCache::Save(unsigned int program, uint64_t key)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	const std::string path = GetPath(key);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	const uint32_t header[4] = { FILE_MAGIC, FILE_VERSION, format, (uint32_t)length };
+	file.write((const char*)header, sizeof(header));
+	file.write(binary.data(), length);
+	if (!file)
+	{
+		// Only costs the next launch a compilation
+		Debug::LogFormat(Debug::MessageType::Warning, "Cannot write program binary. Path - \"%s\"", path.c_str());
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Linked program binaries kept on disk between launches, one file per
+// program named after its key. The key hashes the preprocessed sources of
+// every stage together with the GL vendor, renderer and version, so a driver
+// update or a changed shader misses instead of loading a stale binary. A
+// binary the driver still rejects is relinked from source and replaced
+class ProgramCache
+{
+private:
+	static std::string directory;
+	static std::string driver;
+	static bool enabled;
+
+	static size_t loads;
+	static size_t misses;
+	static size_t rejections;
+
+	static std::string GetPath(uint64_t key);
+	static bool LoadBinary(unsigned int program, uint64_t key);
+public:
+	// Must be called with a GL context. Stays disabled when the driver
+	// supports no binary formats
+	static void Initialize(const std::string& directory);
+
+	static bool IsEnabled() { return enabled; }
+
+	// The sources have to be the exact text given to the compiler
+	static uint64_t GetKey(const std::string& sources);
+
+	// Links the program from the cached binary, false when there is none or
+	// the driver rejected it, the program has to be linked from source then
+	static bool Load(unsigned int program, uint64_t key);
+
+	// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	static void Save(unsigned int program, uint64_t key);
+
+	// Since initialization. Misses include rejections and are linked from source
+	static size_t GetLoads() { return loads; }
+	static size_t GetMisses() { return misses; }
+	static size_t GetRejections() { return rejections; }
+};
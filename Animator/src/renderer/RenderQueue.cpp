@@ -0,0 +1,175 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <GL/glew.h>
+
+#include "RenderState.hpp"
+
+void RenderQueue::GLBackend::UseProgram(unsigned int program)
+{
+	RenderState::UseProgram(program);
+}
+
+void RenderQueue::GLBackend::BindVertexArray(unsigned int vertexArray)
+{
+	RenderState::BindVertexArray(vertexArray);
+}
+
+void RenderQueue::GLBackend::BindTexture(unsigned int texture)
+{
+	RenderState::BindTexture(0, texture);
+}
+
+void RenderQueue::GLBackend::SetPolygonMode(unsigned int mode)
+{
+	RenderState::SetPolygonMode(mode);
+}
+
+void RenderQueue::GLBackend::BindUniformRange(unsigned int buffer, size_t offset, size_t size)
+{
+	glBindBufferRange(GL_UNIFORM_BUFFER, uniformBinding, buffer, offset, size);
+}
+
+void RenderQueue::GLBackend::Draw(const Geometry& geometry)
+{
+	if (geometry.drawCount != 0)
+	{
+		RenderState::BindDrawIndirectBuffer(geometry.indirectBuffer);
+		glMultiDrawElementsIndirect(
+			geometry.mode,
+			geometry.indexType,
+			(void*)geometry.indirectOffset,
+			geometry.drawCount,
+			sizeof(IndirectCommand)
+		);
+	}
+	else if (geometry.indexType == 0 && geometry.instanceCount != 0)
+	{
+		glDrawArraysInstanced(geometry.mode, geometry.baseVertex, geometry.count, geometry.instanceCount);
+	}
+	else if (geometry.indexType == 0)
+	{
+		glDrawArrays(geometry.mode, geometry.baseVertex, geometry.count);
+	}
+	else if (geometry.instanceCount != 0)
+	{
+		glDrawElementsInstancedBaseVertex(
+			geometry.mode,
+			geometry.count,
+			geometry.indexType,
+			(void*)geometry.indexOffset,
+			geometry.instanceCount,
+			geometry.baseVertex
+		);
+	}
+	else
+	{
+		glDrawElementsBaseVertex(
+			geometry.mode,
+			geometry.count,
+			geometry.indexType,
+			(void*)geometry.indexOffset,
+			geometry.baseVertex
+		);
+	}
+}
+
+uint64_t RenderQueue::GetKey(const Item& item)
+{
+	const uint64_t polygonMode = item.polygonMode == GL_FILL ? 0 : 1;
+
+	// Uniform ranges are aligned to at least 16 bytes
+	uint64_t key = item.program & ((1ull << PROGRAM_BITS) - 1);
+	key = (key << POLYGON_MODE_BITS) | polygonMode;
+	key = (key << VERTEX_ARRAY_BITS) | (item.geometry.vertexArray & ((1ull << VERTEX_ARRAY_BITS) - 1));
+	key = (key << TEXTURE_BITS) | (item.texture & ((1ull << TEXTURE_BITS) - 1));
+	key = (key << UNIFORM_OFFSET_BITS) | ((item.uniformOffset / 16) & ((1ull << UNIFORM_OFFSET_BITS) - 1));
+	return key;
+}
+
+void RenderQueue::Submit(const Item& item)
+{
+	entries.push_back(Entry{ GetKey(item), items.size() });
+	items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	std::sort(entries.begin(), entries.end());
+}
+
+const RenderQueue::Statistics& RenderQueue::Execute(Backend& backend)
+{
+	statistics = Statistics();
+	statistics.items = entries.size();
+	if (entries.empty())
+	{
+		return statistics;
+	}
+
+	// The first item sets everything, except a texture of 0
+	Item current = items[entries[0].index];
+	current.program = ~current.program;
+	current.geometry.vertexArray = ~current.geometry.vertexArray;
+	current.texture = 0;
+	current.polygonMode = ~current.polygonMode;
+	current.uniformBuffer = ~current.uniformBuffer;
+
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const Item& item = items[entries[i].index];
+		size_t changes = 0;
+		if (current.program != item.program)
+		{
+			backend.UseProgram(item.program);
+			current.program = item.program;
+			changes++;
+		}
+
+		if (current.geometry.vertexArray != item.geometry.vertexArray)
+		{
+			backend.BindVertexArray(item.geometry.vertexArray);
+			current.geometry.vertexArray = item.geometry.vertexArray;
+			changes++;
+		}
+
+		if (item.texture != 0 && current.texture != item.texture)
+		{
+			backend.BindTexture(item.texture);
+			current.texture = item.texture;
+			changes++;
+		}
+
+		if (current.polygonMode != item.polygonMode)
+		{
+			backend.SetPolygonMode(item.polygonMode);
+			current.polygonMode = item.polygonMode;
+			changes++;
+		}
+
+		if (current.uniformBuffer != item.uniformBuffer
+			|| current.uniformOffset != item.uniformOffset
+			|| current.uniformSize != item.uniformSize)
+		{
+			backend.BindUniformRange(item.uniformBuffer, item.uniformOffset, item.uniformSize);
+			current.uniformBuffer = item.uniformBuffer;
+			current.uniformOffset = item.uniformOffset;
+			current.uniformSize = item.uniformSize;
+			changes++;
+		}
+
+		backend.Draw(item.geometry);
+		statistics.drawCalls++;
+		statistics.draws += item.geometry.drawCount != 0 ? item.geometry.drawCount : 1;
+		statistics.issuedChanges += changes;
+		statistics.avoidedChanges += 5 - changes;
+	}
+
+	return statistics;
+}
+
+void RenderQueue::Clear()
+{
+	items.clear();
+	entries.clear();
+}
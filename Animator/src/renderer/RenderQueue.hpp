@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Draws submitted during a frame, sorted so items sharing a program, vertex
+// array and texture run next to each other, then executed through a backend
+// issuing only the state that differs from the previous item. Items with
+// equal keys keep their submission order, so execution is deterministic
+class RenderQueue
+{
+public:
+	// Vertex array and draw call of a mesh
+	struct Geometry
+	{
+		unsigned int vertexArray;
+		// GL_TRIANGLES, GL_POINTS...
+		unsigned int mode;
+		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, 0 draws arrays
+		unsigned int indexType;
+		// In bytes
+		size_t indexOffset;
+		size_t count;
+		// First vertex when drawing arrays
+		int baseVertex;
+		// 0 draws without instancing
+		size_t instanceCount;
+		// Non-zero draws that many IndirectCommands read from the indirect
+		// buffer at the offset with one glMultiDrawElementsIndirect, count,
+		// baseVertex and instanceCount are ignored then
+		size_t drawCount;
+		unsigned int indirectBuffer;
+		size_t indirectOffset;
+	};
+
+	// Layout of a glMultiDrawElementsIndirect command
+	struct IndirectCommand
+	{
+		uint32_t count;
+		uint32_t instanceCount;
+		uint32_t firstIndex;
+		int32_t baseVertex;
+		uint32_t baseInstance;
+	};
+
+	struct Item
+	{
+		unsigned int program;
+		Geometry geometry;
+		// Bound to unit 0, 0 keeps the bound texture
+		unsigned int texture;
+		// For GL_FRONT_AND_BACK
+		unsigned int polygonMode;
+		// Range bound to the object uniform block binding
+		unsigned int uniformBuffer;
+		size_t uniformOffset;
+		size_t uniformSize;
+	};
+
+	class Backend
+	{
+	public:
+		virtual ~Backend() { }
+
+		virtual void UseProgram(unsigned int program) = 0;
+		virtual void BindVertexArray(unsigned int vertexArray) = 0;
+		virtual void BindTexture(unsigned int texture) = 0;
+		virtual void SetPolygonMode(unsigned int mode) = 0;
+		virtual void BindUniformRange(unsigned int buffer, size_t offset, size_t size) = 0;
+		virtual void Draw(const Geometry& geometry) = 0;
+	};
+
+	// Goes through RenderState, which also drops changes repeated across frames
+	class GLBackend : public Backend
+	{
+	private:
+		unsigned int uniformBinding;
+	public:
+		GLBackend(unsigned int uniformBinding) : uniformBinding(uniformBinding) { }
+
+		void UseProgram(unsigned int program) override;
+		void BindVertexArray(unsigned int vertexArray) override;
+		void BindTexture(unsigned int texture) override;
+		void SetPolygonMode(unsigned int mode) override;
+		void BindUniformRange(unsigned int buffer, size_t offset, size_t size) override;
+		void Draw(const Geometry& geometry) override;
+	};
+
+	// Issues nothing, only counts the calls, for benchmarks
+	class NullBackend : public Backend
+	{
+	private:
+		size_t changes = 0;
+		size_t draws = 0;
+	public:
+		void UseProgram(unsigned int program) override { changes++; }
+		void BindVertexArray(unsigned int vertexArray) override { changes++; }
+		void BindTexture(unsigned int texture) override { changes++; }
+		void SetPolygonMode(unsigned int mode) override { changes++; }
+		void BindUniformRange(unsigned int buffer, size_t offset, size_t size) override { changes++; }
+		void Draw(const Geometry& geometry) override { draws++; }
+
+		size_t GetChanges() const { return changes; }
+		size_t GetDraws() const { return draws; }
+	};
+
+	struct Statistics
+	{
+		size_t items = 0;
+		// Of the five states each item sets
+		size_t issuedChanges = 0;
+		size_t avoidedChanges = 0;
+		// GL draw calls and the meshes they drew, a multi-draw call draws many
+		size_t drawCalls = 0;
+		size_t draws = 0;
+	};
+private:
+	struct Entry
+	{
+		uint64_t key;
+		size_t index;
+
+		bool operator<(const Entry& other) const { return key < other.key || (key == other.key && index < other.index); }
+	};
+
+	std::vector<Item> items;
+	std::vector<Entry> entries;
+	Statistics statistics;
+
+	static uint64_t GetKey(const Item& item);
+public:
+	// Bits of each field of the key, from the most significant. Ids wider than
+	// their field only sort less well
+	static const size_t PROGRAM_BITS = 12;
+	static const size_t POLYGON_MODE_BITS = 1;
+	static const size_t VERTEX_ARRAY_BITS = 12;
+	static const size_t TEXTURE_BITS = 12;
+	static const size_t UNIFORM_OFFSET_BITS = 27;
+
+	void Submit(const Item& item);
+	void Sort();
+
+	// In submission order unless sorted since the last submit
+	const Statistics& Execute(Backend& backend);
+
+	void Clear();
+
+	size_t GetItemsCount() const { return items.size(); }
+
+	// Of the last execution
+	const Statistics& GetStatistics() const { return statistics; }
+};
@@ -0,0 +1,153 @@
+#include "RenderState.hpp"
+
+#include <GL/glew.h>
+
+unsigned int RenderState::program = RenderState::UNKNOWN;
+unsigned int RenderState::vertexArray = RenderState::UNKNOWN;
+unsigned int RenderState::arrayBuffer = RenderState::UNKNOWN;
+unsigned int RenderState::drawIndirectBuffer = RenderState::UNKNOWN;
+unsigned int RenderState::activeTextureUnit = RenderState::UNKNOWN;
+unsigned int RenderState::textures[RenderState::TEXTURE_UNITS_COUNT] = {
+	UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN,
+	UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN
+};
+unsigned int RenderState::polygonMode = RenderState::UNKNOWN;
+
+size_t RenderState::issuedChanges = 0;
+size_t RenderState::skippedChanges = 0;
+size_t RenderState::frameIssuedChanges = 0;
+size_t RenderState::frameSkippedChanges = 0;
+
+bool RenderState::Change(unsigned int& current, unsigned int value)
+{
+	if (current == value)
+	{
+		frameSkippedChanges++;
+		return false;
+	}
+
+	current = value;
+	frameIssuedChanges++;
+	return true;
+}
+
+void RenderState::UseProgram(unsigned int program)
+{
+	if (Change(RenderState::program, program))
+	{
+		glUseProgram(program);
+	}
+}
+
+void RenderState::BindVertexArray(unsigned int vertexArray)
+{
+	if (Change(RenderState::vertexArray, vertexArray))
+	{
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void RenderState::BindArrayBuffer(unsigned int buffer)
+{
+	if (Change(arrayBuffer, buffer))
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	}
+}
+
+void RenderState::BindDrawIndirectBuffer(unsigned int buffer)
+{
+	if (Change(drawIndirectBuffer, buffer))
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	}
+}
+
+void RenderState::BindTexture(unsigned int unit, unsigned int texture)
+{
+	if (!Change(textures[unit], texture))
+	{
+		return;
+	}
+
+	if (activeTextureUnit != unit)
+	{
+		glActiveTexture(GL_TEXTURE0 + unit);
+		activeTextureUnit = unit;
+		frameIssuedChanges++;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void RenderState::SetPolygonMode(unsigned int mode)
+{
+	if (Change(polygonMode, mode))
+	{
+		glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+}
+
+void RenderState::ForgetProgram(unsigned int program)
+{
+	// A deleted program stays in use until another one is, its name may not be reused before
+	if (RenderState::program == program)
+	{
+		RenderState::program = UNKNOWN;
+	}
+}
+
+void RenderState::ForgetVertexArray(unsigned int vertexArray)
+{
+	if (RenderState::vertexArray == vertexArray)
+	{
+		RenderState::vertexArray = 0;
+	}
+}
+
+void RenderState::ForgetBuffer(unsigned int buffer)
+{
+	if (arrayBuffer == buffer)
+	{
+		arrayBuffer = 0;
+	}
+
+	if (drawIndirectBuffer == buffer)
+	{
+		drawIndirectBuffer = 0;
+	}
+}
+
+void RenderState::ForgetTexture(unsigned int texture)
+{
+	for (size_t i = 0; i < TEXTURE_UNITS_COUNT; i++)
+	{
+		if (textures[i] == texture)
+		{
+			textures[i] = 0;
+		}
+	}
+}
+
+void RenderState::Invalidate()
+{
+	program = UNKNOWN;
+	vertexArray = UNKNOWN;
+	arrayBuffer = UNKNOWN;
+	drawIndirectBuffer = UNKNOWN;
+	activeTextureUnit = UNKNOWN;
+	for (size_t i = 0; i < TEXTURE_UNITS_COUNT; i++)
+	{
+		textures[i] = UNKNOWN;
+	}
+
+	polygonMode = UNKNOWN;
+}
+
+void RenderState::EndFrame()
+{
+	issuedChanges = frameIssuedChanges;
+	skippedChanges = frameSkippedChanges;
+	frameIssuedChanges = 0;
+	frameSkippedChanges = 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <climits>
+
+// Shadow of the GL bindings the renderer changes. Every change goes through
+// here and calls that would set the value already current are dropped. Code
+// that changes this state behind its back, e.g. the ImGui backend, has to
+// restore it or call Invalidate. Deleting a bound object unbinds it, so
+// objects are forgotten right before they are deleted
+class RenderState
+{
+public:
+	static const size_t TEXTURE_UNITS_COUNT = 16;
+private:
+	// Not known yet, the next change is always issued
+	static const unsigned int UNKNOWN = UINT_MAX;
+
+	static unsigned int program;
+	static unsigned int vertexArray;
+	static unsigned int arrayBuffer;
+	static unsigned int drawIndirectBuffer;
+	static unsigned int activeTextureUnit;
+	static unsigned int textures[TEXTURE_UNITS_COUNT];
+	static unsigned int polygonMode;
+
+	static size_t issuedChanges;
+	static size_t skippedChanges;
+	static size_t frameIssuedChanges;
+	static size_t frameSkippedChanges;
+
+	static bool Change(unsigned int& current, unsigned int value);
+public:
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vertexArray);
+	static void BindArrayBuffer(unsigned int buffer);
+	static void BindDrawIndirectBuffer(unsigned int buffer);
+
+	// GL_TEXTURE_2D binding of the unit, the active unit is switched only for an issued bind
+	static void BindTexture(unsigned int unit, unsigned int texture);
+
+	// For GL_FRONT_AND_BACK
+	static void SetPolygonMode(unsigned int mode);
+
+	static void ForgetProgram(unsigned int program);
+	static void ForgetVertexArray(unsigned int vertexArray);
+	static void ForgetBuffer(unsigned int buffer);
+	static void ForgetTexture(unsigned int texture);
+
+	static void Invalidate();
+
+	// Closes the frame of the state change counters
+	static void EndFrame();
+
+	// Changes in the last frame
+	static size_t GetIssuedChanges() { return issuedChanges; }
+	static size_t GetSkippedChanges() { return skippedChanges; }
+};
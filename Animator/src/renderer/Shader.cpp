@@ -1,9 +1,13 @@
 #include "Shader.hpp"
 
+#include <cstring>
 #include <iostream>
+#include <algorithm>
 #include <GL/glew.h>
 
 #include "ShaderError.hpp"
+#include "RenderState.hpp"
+#include "ProgramCache.hpp"
 
 bool Shader::IsValidShaderType(unsigned int shaderType)
 {
@@ -33,22 +37,134 @@ bool Shader::ShaderAttached(unsigned int shaderType)
 	}
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+void Shader::Reflect()
 {
-	auto it = uniformLocations.find(name);
+	int count = 0;
+	int maxLength = 0;
+	glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-	if (it == uniformLocations.end())
+	std::vector<char> name(std::max(maxLength, 1));
+	for (int i = 0; i < count; i++)
 	{
-		int location = glGetUniformLocation(program, name.c_str());
-		if (location < 0)
+		int length = 0;
+		int size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(program, i, (int)name.size(), &length, &size, &type, &name[0]);
+
+		UniformInfo uniform;
+		uniform.name.assign(&name[0], length);
+		uniform.location = glGetUniformLocation(program, uniform.name.c_str());
+		if (uniform.location < 0)
 		{
-			throw new ShaderError("No uniform with name - " + name);
+			// Members of uniform blocks are set through their buffers
+			continue;
 		}
 
-		return uniformLocations[name] = location;
+		uniform.type = type;
+		uniform.shadowOffset = shadowValues.size();
+		uniform.shadowSize = GetUniformTypeSize(type);
+		shadowValues.resize(shadowValues.size() + uniform.shadowSize);
+
+		// Arrays are reported as "name[0]"
+		uniformIndices[uniform.name] = uniforms.size();
+		const size_t bracket = uniform.name.find('[');
+		if (bracket != std::string::npos)
+		{
+			uniformIndices.emplace(uniform.name.substr(0, bracket), uniforms.size());
+		}
+
+		uniforms.push_back(uniform);
+	}
+}
+
+size_t Shader::FindUniform(const std::string& name) const
+{
+	auto iterator = uniformIndices.find(name);
+	if (iterator == uniformIndices.end())
+	{
+		throw ShaderError("No uniform with name - " + name);
+	}
+
+	return iterator->second;
+}
+
+size_t Shader::ResolveUniform(const std::string& name, unsigned int type) const
+{
+	const size_t index = FindUniform(name);
+	const unsigned int uniformType = uniforms[index].type;
+	if (uniformType != type && !(type == GL_INT && IsSamplerType(uniformType)))
+	{
+		throw ShaderError("Uniform type mismatch - " + name);
 	}
 
-	return uniformLocations[name];
+	return index;
+}
+
+bool Shader::UpdateShadow(size_t index, const void* value, size_t size)
+{
+	UniformInfo& uniform = uniforms[index];
+	if (size > uniform.shadowSize)
+	{
+		// Set with a type other than declared, nothing to compare with
+		return true;
+	}
+
+	unsigned char* shadow = &shadowValues[uniform.shadowOffset];
+	if (uniform.assigned && std::memcmp(shadow, value, size) == 0)
+	{
+		return false;
+	}
+
+	std::memcpy(shadow, value, size);
+	uniform.assigned = true;
+	return true;
+}
+
+unsigned int Shader::GetUniformType(const glm::vec2*) { return GL_FLOAT_VEC2; }
+unsigned int Shader::GetUniformType(const glm::vec3*) { return GL_FLOAT_VEC3; }
+unsigned int Shader::GetUniformType(const glm::vec4*) { return GL_FLOAT_VEC4; }
+unsigned int Shader::GetUniformType(const glm::mat3*) { return GL_FLOAT_MAT3; }
+unsigned int Shader::GetUniformType(const glm::mat4*) { return GL_FLOAT_MAT4; }
+unsigned int Shader::GetUniformType(const unsigned int*) { return GL_UNSIGNED_INT; }
+unsigned int Shader::GetUniformType(const float*) { return GL_FLOAT; }
+unsigned int Shader::GetUniformType(const bool*) { return GL_BOOL; }
+unsigned int Shader::GetUniformType(const int*) { return GL_INT; }
+
+size_t Shader::GetUniformTypeSize(unsigned int type)
+{
+	switch (type)
+	{
+	case GL_FLOAT_VEC2:
+		return sizeof(glm::vec2);
+	case GL_FLOAT_VEC3:
+		return sizeof(glm::vec3);
+	case GL_FLOAT_VEC4:
+		return sizeof(glm::vec4);
+	case GL_FLOAT_MAT3:
+		return sizeof(glm::mat3);
+	case GL_FLOAT_MAT4:
+		return sizeof(glm::mat4);
+	default:
+		// Scalars, booleans and samplers are sent as one 4-byte value
+		return sizeof(float);
+	}
+}
+
+bool Shader::IsSamplerType(unsigned int type)
+{
+	switch (type)
+	{
+	case GL_SAMPLER_1D:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_BUFFER:
+		return true;
+	default:
+		return false;
+	}
 }
 
 std::string Shader::ShaderTypeToString(unsigned int shaderType)
@@ -77,6 +193,7 @@ Shader::Shader()
 
 Shader::~Shader()
 {
+	RenderState::ForgetProgram(program);
 	glDeleteProgram(program);
 }
 
@@ -97,6 +214,64 @@ void Shader::Add(unsigned int shaderType, const std::string& source)
 		throw ShaderError(ShaderTypeToString(shaderType) + " shader already attached");
 	}
 
+	stages.push_back(Stage{ shaderType, Preprocess(source) });
+	switch (shaderType)
+	{
+	case GL_VERTEX_SHADER:
+		vertexShaderAttached = true;
+		break;
+	case GL_GEOMETRY_SHADER:
+		geometryShaderAttached = true;
+		break;
+	case GL_FRAGMENT_SHADER:
+		fragmentShaderAttached = true;
+		break;
+	}
+}
+
+void Shader::AddLibrary(unsigned int shaderType, const std::string& source)
+{
+	if (linked)
+	{
+		return;
+	}
+
+	if (!IsValidShaderType(shaderType))
+	{
+		throw ShaderError("Unknown shader type");
+	}
+
+	stages.push_back(Stage{ shaderType, Preprocess(source) });
+}
+
+void Shader::AddPrelude(const std::string& source)
+{
+	prelude += source;
+}
+
+static bool StartsWith(const std::string& text, size_t position, const char* prefix)
+{
+	return text.compare(position, std::strlen(prefix), prefix) == 0;
+}
+
+std::string Shader::Preprocess(const std::string& source) const
+{
+	// #version and the #extension lines right after it have to stay in front of
+	// the prelude, the line directive keeps error lines matching the file
+	size_t versionEnd = 0;
+	size_t versionLines = 0;
+	while (StartsWith(source, versionEnd, versionLines == 0 ? "#version" : "#extension"))
+	{
+		versionEnd = source.find('\n', versionEnd);
+		versionEnd = versionEnd == std::string::npos ? source.size() : versionEnd + 1;
+		versionLines++;
+	}
+
+	return source.substr(0, versionEnd) + prelude + "#line " + std::to_string(versionLines + 1) + "\n" + source.substr(versionEnd);
+}
+
+void Shader::Compile(unsigned int shaderType, const std::string& source)
+{
 	unsigned int shader = glCreateShader(shaderType);
 	if (!shader)
 	{
@@ -127,19 +302,6 @@ void Shader::Add(unsigned int shaderType, const std::string& source)
 		throw ShaderError("Compilation failed: " + log);
 	}
 
-	switch (shaderType)
-	{
-	case GL_VERTEX_SHADER:
-		vertexShaderAttached = true;
-		break;
-	case GL_GEOMETRY_SHADER:
-		geometryShaderAttached = true;
-		break;
-	case GL_FRAGMENT_SHADER:
-		fragmentShaderAttached = true;
-		break;
-	}
-
 	glAttachShader(program, shader);
 	glDeleteShader(shader);
 }
@@ -151,6 +313,33 @@ void Shader::Link()
 		return;
 	}
 
+	std::string sources;
+	for (const Stage& stage : stages)
+	{
+		sources += std::to_string(stage.type) + "\n" + stage.source + '\0';
+	}
+
+	// A rejected binary leaves the program unlinked, it is linked from source then
+	const uint64_t key = ProgramCache::GetKey(sources);
+	if (!ProgramCache::Load(program, key))
+	{
+		LinkFromSource();
+		ProgramCache::Save(program, key);
+	}
+
+	stages.clear();
+	linked = true;
+	Reflect();
+}
+
+void Shader::LinkFromSource()
+{
+	for (const Stage& stage : stages)
+	{
+		Compile(stage.type, stage.source);
+	}
+
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(program);
 	
 	int status;
@@ -171,8 +360,6 @@ void Shader::Link()
 
 		throw ShaderError("Link failed: " + log);
 	}
-
-	linked = true;
 }
 
 void Shader::Use()
@@ -182,68 +369,124 @@ void Shader::Use()
 		return;
 	}
 
-	glUseProgram(program);
+	RenderState::UseProgram(program);
+}
+
+void Shader::Write(size_t index, const glm::vec2& vector)
+{
+	if (UpdateShadow(index, &vector, sizeof(vector)))
+	{
+		glProgramUniform2fv(program, uniforms[index].location, 1, &vector[0]);
+	}
+}
+
+void Shader::Write(size_t index, const glm::vec3& vector)
+{
+	if (UpdateShadow(index, &vector, sizeof(vector)))
+	{
+		glProgramUniform3fv(program, uniforms[index].location, 1, &vector[0]);
+	}
+}
+
+void Shader::Write(size_t index, const glm::vec4& vector)
+{
+	if (UpdateShadow(index, &vector, sizeof(vector)))
+	{
+		glProgramUniform4fv(program, uniforms[index].location, 1, &vector[0]);
+	}
+}
+
+void Shader::Write(size_t index, const glm::mat3& matrix)
+{
+	if (UpdateShadow(index, &matrix, sizeof(matrix)))
+	{
+		glProgramUniformMatrix3fv(program, uniforms[index].location, 1, false, &matrix[0][0]);
+	}
+}
+
+void Shader::Write(size_t index, const glm::mat4& matrix)
+{
+	if (UpdateShadow(index, &matrix, sizeof(matrix)))
+	{
+		glProgramUniformMatrix4fv(program, uniforms[index].location, 1, false, &matrix[0][0]);
+	}
+}
+
+void Shader::Write(size_t index, unsigned int value)
+{
+	if (UpdateShadow(index, &value, sizeof(value)))
+	{
+		glProgramUniform1ui(program, uniforms[index].location, value);
+	}
+}
+
+void Shader::Write(size_t index, float value)
+{
+	if (UpdateShadow(index, &value, sizeof(value)))
+	{
+		glProgramUniform1f(program, uniforms[index].location, value);
+	}
+}
+
+void Shader::Write(size_t index, bool value)
+{
+	Write(index, int(value));
+}
+
+void Shader::Write(size_t index, int value)
+{
+	if (UpdateShadow(index, &value, sizeof(value)))
+	{
+		glProgramUniform1i(program, uniforms[index].location, value);
+	}
 }
 
 void Shader::SetUniform(const std::string& name, float x, float y, float z)
 {
-	int location = GetUniformLocation(name);
-	glUniform3f(location, x, y, z);
+	Write(FindUniform(name), glm::vec3{ x, y, z });
 }
 
 void Shader::SetUniform(const std::string& name, const glm::vec2& vector)
 {
-	int location = GetUniformLocation(name);
-	glUniform2f(location, vector.x, vector.y);
+	Write(FindUniform(name), vector);
 }
 
 void Shader::SetUniform(const std::string& name, const glm::vec3& vector)
 {
-
-	int location = GetUniformLocation(name);
-	glUniform3fv(location, 1, &vector[0]);
+	Write(FindUniform(name), vector);
 }
 
 void Shader::SetUniform(const std::string& name, const glm::vec4& vector)
 {
-
-	int location = GetUniformLocation(name);
-	glUniform4fv(location, 1, &vector[0]);
+	Write(FindUniform(name), vector);
 }
 
 void Shader::SetUniform(const std::string& name, const glm::mat3& matrix)
 {
-
-	int location = GetUniformLocation(name);
-	glUniformMatrix3fv(location, 1, false, &matrix[0][0]);
+	Write(FindUniform(name), matrix);
 }
 
 void Shader::SetUniform(const std::string& name, const glm::mat4& matrix)
 {
-	int location = GetUniformLocation(name);
-	glUniformMatrix4fv(location, 1, false, &matrix[0][0]);
+	Write(FindUniform(name), matrix);
 }
 
 void Shader::SetUniform(const std::string& name, unsigned int value)
 {
-	int location = GetUniformLocation(name);
-	glUniform1ui(location, value);
+	Write(FindUniform(name), value);
 }
 
 void Shader::SetUniform(const std::string& name, float value)
 {
-	int location = GetUniformLocation(name);
-	glUniform1f(location, value);
+	Write(FindUniform(name), value);
 }
 
 void Shader::SetUniform(const std::string& name, bool value)
 {
-	int location = GetUniformLocation(name);
-	glUniform1i(location, value);
+	Write(FindUniform(name), value);
 }
 
 void Shader::SetUniform(const std::string& name, int value)
 {
-	int location = GetUniformLocation(name);
-	glUniform1i(location, value);
+	Write(FindUniform(name), value);
 }
@@ -1,32 +1,135 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
 #include <unordered_map>
 #include <glm/glm.hpp>
 
+#include "ShaderError.hpp"
+
 class Shader
 {
+public:
+	// Index into the uniform table the program builds when it is linked.
+	// Resolved once by name, then setting the uniform needs no lookup
+	template<typename T>
+	class Uniform
+	{
+		friend class Shader;
+	private:
+		size_t index = SIZE_MAX;
+
+		Uniform(size_t index) : index(index) { }
+	public:
+		Uniform() { }
+
+		bool IsValid() const { return index != SIZE_MAX; }
+	};
 private:
+	struct UniformInfo
+	{
+		std::string name;
+		int location;
+		unsigned int type;
+		// Last value sent, calls with the same value are skipped
+		size_t shadowOffset;
+		size_t shadowSize;
+		bool assigned = false;
+	};
+
+	// Compiled when the program is linked and is not in the program cache
+	struct Stage
+	{
+		unsigned int type;
+		// With the prelude, as given to the compiler
+		std::string source;
+	};
+
 	bool vertexShaderAttached = false;
 	bool fragmentShaderAttached = false;
 	bool geometryShaderAttached = false;
 	bool linked = false;
 	unsigned int program;
-	std::unordered_map<std::string, unsigned int> uniformLocations;
+	std::vector<UniformInfo> uniforms;
+	std::vector<unsigned char> shadowValues;
+	std::unordered_map<std::string, size_t> uniformIndices;
+	std::string prelude;
+	std::vector<Stage> stages;
 
 	bool IsValidShaderType(unsigned int shaderType);
 	bool ShaderAttached(unsigned int shaderType);
-	int GetUniformLocation(const std::string& name);
+	std::string Preprocess(const std::string& source) const;
+	void Compile(unsigned int shaderType, const std::string& source);
+	void LinkFromSource();
+	void Reflect();
+	size_t FindUniform(const std::string& name) const;
+	size_t ResolveUniform(const std::string& name, unsigned int type) const;
+	bool UpdateShadow(size_t index, const void* value, size_t size);
+
+	void Write(size_t index, const glm::vec2& vector);
+	void Write(size_t index, const glm::vec3& vector);
+	void Write(size_t index, const glm::vec4& vector);
+	void Write(size_t index, const glm::mat3& matrix);
+	void Write(size_t index, const glm::mat4& matrix);
+	void Write(size_t index, unsigned int value);
+	void Write(size_t index, float value);
+	void Write(size_t index, bool value);
+	void Write(size_t index, int value);
+
+	static unsigned int GetUniformType(const glm::vec2*);
+	static unsigned int GetUniformType(const glm::vec3*);
+	static unsigned int GetUniformType(const glm::vec4*);
+	static unsigned int GetUniformType(const glm::mat3*);
+	static unsigned int GetUniformType(const glm::mat4*);
+	static unsigned int GetUniformType(const unsigned int*);
+	static unsigned int GetUniformType(const float*);
+	static unsigned int GetUniformType(const bool*);
+	static unsigned int GetUniformType(const int*);
 
+	static size_t GetUniformTypeSize(unsigned int type);
+	static bool IsSamplerType(unsigned int type);
 	static std::string ShaderTypeToString(unsigned int shaderType);
 public:
 	Shader();
 	~Shader();
 
 	void Add(unsigned int shaderType, const std::string& source);
+
+	// Functions without main linked into a stage next to the shader added for it
+	void AddLibrary(unsigned int shaderType, const std::string& source);
+
+	// Declarations inserted after the #version line of every stage and library added afterwards
+	void AddPrelude(const std::string& source);
+
+	// Compiles the added stages and links them, unless ProgramCache has the
+	// binary of the same sources. Compilation errors are thrown from here
 	void Link();
 	void Use();
 
+	unsigned int GetId() const { return program; }
+
+	// Throws ShaderError when the program has no such uniform of type T,
+	// int uniforms also match samplers
+	template<typename T>
+	Uniform<T> GetUniform(const std::string& name) const
+	{
+		return Uniform<T>(ResolveUniform(name, GetUniformType((const T*)nullptr)));
+	}
+
+	// The program does not have to be in use. Throws ShaderError for a handle
+	// not returned by GetUniform
+	template<typename T>
+	void SetUniform(Uniform<T> uniform, const T& value)
+	{
+		if (!uniform.IsValid() || uniform.index >= uniforms.size())
+		{
+			throw ShaderError("Invalid uniform handle");
+		}
+
+		Write(uniform.index, value);
+	}
+
 	void SetUniform(const std::string& name, float x, float y, float z);
 	void SetUniform(const std::string& name, const glm::vec2& vector);
 	void SetUniform(const std::string& name, const glm::vec3& vector);
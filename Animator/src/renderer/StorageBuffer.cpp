@@ -0,0 +1,23 @@
+#include "StorageBuffer.hpp"
+
+#include <GL/glew.h>
+
+#include "RenderState.hpp"
+
+StorageBuffer::StorageBuffer(const void* data, size_t size) : size(size)
+{
+	glCreateBuffers(1, &buffer);
+	// Zero sized storage is an error
+	glNamedBufferStorage(buffer, size == 0 ? 1 : size, size == 0 ? nullptr : data, 0);
+}
+
+StorageBuffer::~StorageBuffer()
+{
+	RenderState::ForgetBuffer(buffer);
+	glDeleteBuffers(1, &buffer);
+}
+
+void StorageBuffer::BindBase(unsigned int index) const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Immutable buffer read by shaders as a shader storage block
+class StorageBuffer
+{
+private:
+	unsigned int buffer;
+	size_t size;
+public:
+	StorageBuffer(const void* data, size_t size);
+	~StorageBuffer();
+
+	StorageBuffer(const StorageBuffer&) = delete;
+	StorageBuffer& operator=(const StorageBuffer&) = delete;
+
+	// To the indexed GL_SHADER_STORAGE_BUFFER binding of the block
+	void BindBase(unsigned int index) const;
+
+	unsigned int GetId() const { return buffer; }
+	size_t GetSize() const { return size; }
+};
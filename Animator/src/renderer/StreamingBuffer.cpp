@@ -0,0 +1,135 @@
+#include "StreamingBuffer.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <GL/glew.h>
+
+#include "RenderState.hpp"
+
+StreamingBuffer::StreamingBuffer(size_t regionSize) : regionSize(regionSize)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &buffer);
+	glNamedBufferStorage(buffer, regionSize * REGIONS_COUNT, nullptr, flags);
+	mapping = (char*)glMapNamedBufferRange(buffer, 0, regionSize * REGIONS_COUNT, flags);
+	if (mapping == nullptr)
+	{
+		glDeleteBuffers(1, &buffer);
+		throw std::runtime_error("Failed to map streaming buffer");
+	}
+
+	int alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+	{
+		uniformAlignment = alignment;
+	}
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	for (size_t i = 0; i < REGIONS_COUNT; i++)
+	{
+		if (fences[i] != nullptr)
+		{
+			glDeleteSync((GLsync)fences[i]);
+		}
+	}
+
+	glUnmapNamedBuffer(buffer);
+	RenderState::ForgetBuffer(buffer);
+	glDeleteBuffers(1, &buffer);
+}
+
+void StreamingBuffer::BeginFrame()
+{
+	if (frameStarted)
+	{
+		throw std::runtime_error("Streaming buffer frame is already started");
+	}
+
+	region = (region + 1) % REGIONS_COUNT;
+	head = 0;
+	frameStarted = true;
+
+	GLsync fence = (GLsync)fences[region];
+	if (fence == nullptr)
+	{
+		return;
+	}
+
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		waits++;
+		do
+		{
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	fences[region] = nullptr;
+}
+
+void StreamingBuffer::EndFrame()
+{
+	if (!frameStarted)
+	{
+		throw std::runtime_error("Streaming buffer frame is not started");
+	}
+
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frameStarted = false;
+	frameBytes = head;
+	if (frameBytes > peakFrameBytes)
+	{
+		peakFrameBytes = frameBytes;
+	}
+}
+
+StreamingBuffer::Allocation StreamingBuffer::Allocate(size_t size, size_t alignment)
+{
+	if (!frameStarted)
+	{
+		throw std::runtime_error("Streaming buffer frame is not started");
+	}
+
+	const size_t regionOffset = region * regionSize;
+	size_t offset = regionOffset + head;
+	if (alignment > 1)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+	}
+
+	if (offset + size > regionOffset + regionSize)
+	{
+		throw std::runtime_error("Streaming buffer region is full");
+	}
+
+	head = offset + size - regionOffset;
+	return Allocation{ mapping + offset, offset, size };
+}
+
+StreamingBuffer::Allocation StreamingBuffer::Allocate(const void* data, size_t size, size_t alignment)
+{
+	Allocation allocation = Allocate(size, alignment);
+	std::memcpy(allocation.data, data, size);
+	return allocation;
+}
+
+StreamingBuffer::Allocation StreamingBuffer::AllocateUniform(const void* data, size_t size)
+{
+	return Allocate(data, size, uniformAlignment);
+}
+
+void StreamingBuffer::BindRange(unsigned int target, unsigned int index, const Allocation& allocation) const
+{
+	glBindBufferRange(target, index, buffer, allocation.offset, allocation.size);
+}
+
+void StreamingBuffer::ResetStatistics()
+{
+	peakFrameBytes = 0;
+	waits = 0;
+}
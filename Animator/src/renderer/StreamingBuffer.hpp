@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+
+// Persistently mapped buffer for data rewritten every frame. The storage is
+// split into REGIONS_COUNT regions used in turn, one per frame, and a region
+// is written again only after the GPU has signaled the fence of the frame
+// that last used it. Allocations are valid until the end of the frame
+class StreamingBuffer
+{
+public:
+	struct Allocation
+	{
+		void* data;
+		size_t offset;
+		size_t size;
+	};
+
+	static const size_t REGIONS_COUNT = 3;
+	static const size_t DEFAULT_REGION_SIZE = 4 * 1024 * 1024;
+private:
+	unsigned int buffer = 0;
+	char* mapping = nullptr;
+	size_t regionSize;
+	size_t uniformAlignment = 1;
+
+	// GLsync objects, null until the region has been used once
+	void* fences[REGIONS_COUNT] = { };
+	size_t region = 0;
+	size_t head = 0;
+	bool frameStarted = false;
+
+	size_t frameBytes = 0;
+	size_t peakFrameBytes = 0;
+	size_t waits = 0;
+public:
+	StreamingBuffer(size_t regionSize = DEFAULT_REGION_SIZE);
+	~StreamingBuffer();
+
+	StreamingBuffer(const StreamingBuffer&) = delete;
+	StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+	// Moves to the next region, waiting for the GPU if it still reads it
+	void BeginFrame();
+	void EndFrame();
+
+	// The offset is a multiple of the alignment, which does not have to be
+	// a power of two. Vertex data allocated with its stride as the alignment
+	// starts at vertex offset / stride of a vertex array bound to this buffer
+	Allocation Allocate(size_t size, size_t alignment);
+	Allocation Allocate(const void* data, size_t size, size_t alignment);
+
+	// Aligned for glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+	Allocation AllocateUniform(const void* data, size_t size);
+
+	// Binds the allocation to an indexed target such as GL_UNIFORM_BUFFER
+	void BindRange(unsigned int target, unsigned int index, const Allocation& allocation) const;
+
+	unsigned int GetId() const { return buffer; }
+	size_t GetRegionSize() const { return regionSize; }
+
+	// Bytes allocated in the last completed frame
+	size_t GetFrameBytes() const { return frameBytes; }
+	size_t GetPeakFrameBytes() const { return peakFrameBytes; }
+
+	// Frames that had to wait for the GPU before reusing a region
+	size_t GetWaits() const { return waits; }
+
+	void ResetStatistics();
+};
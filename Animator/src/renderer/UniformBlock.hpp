@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// GLSL name and std140 base alignment of the types a uniform block field may have.
+// mat3 is stored as three vec4 columns, so its C++ type is glm::mat3x4
+template<typename T>
+struct Std140;
+
+template<> struct Std140<float> { static const size_t ALIGNMENT = 4; static const char* Name() { return "float"; } };
+template<> struct Std140<int32_t> { static const size_t ALIGNMENT = 4; static const char* Name() { return "int"; } };
+template<> struct Std140<uint32_t> { static const size_t ALIGNMENT = 4; static const char* Name() { return "uint"; } };
+template<> struct Std140<glm::vec2> { static const size_t ALIGNMENT = 8; static const char* Name() { return "vec2"; } };
+template<> struct Std140<glm::vec3> { static const size_t ALIGNMENT = 16; static const char* Name() { return "vec3"; } };
+template<> struct Std140<glm::vec4> { static const size_t ALIGNMENT = 16; static const char* Name() { return "vec4"; } };
+template<> struct Std140<glm::mat3x4> { static const size_t ALIGNMENT = 16; static const char* Name() { return "mat3"; } };
+template<> struct Std140<glm::mat4> { static const size_t ALIGNMENT = 16; static const char* Name() { return "mat4"; } };
+
+#define UNIFORM_BLOCK_MEMBER(type, name) type name;
+
+#define UNIFORM_BLOCK_CHECK(type, name) \
+	static_assert(offsetof(Self, name) % Std140<type>::ALIGNMENT == 0, #name " is not std140 aligned, add padding before it");
+
+#define UNIFORM_BLOCK_GLSL(type, name) + "\t" + Std140<type>::Name() + " u_" #name ";\n"
+
+// Declares the struct Name with the fields listed by FIELDS(FIELD) together
+// with GetDeclaration(), the GLSL declaration of the std140 block at binding
+// Binding whose members are the fields prefixed with u_. C++ packs the fields
+// without gaps, so the offsets match std140 as long as every field is aligned,
+// which is checked when GetDeclaration is compiled
+#define DECLARE_UNIFORM_BLOCK(Name, Binding, FIELDS) \
+	struct Name \
+	{ \
+		static const unsigned int BINDING = Binding; \
+		FIELDS(UNIFORM_BLOCK_MEMBER) \
+		static std::string GetDeclaration() \
+		{ \
+			typedef Name Self; \
+			FIELDS(UNIFORM_BLOCK_CHECK) \
+			static_assert(sizeof(Name) % 16 == 0, "Size of " #Name " must be a multiple of 16 bytes"); \
+			return std::string("layout (std140, binding=") + std::to_string(Binding) + ") uniform " #Name "\n{\n" \
+				FIELDS(UNIFORM_BLOCK_GLSL) + "};\n"; \
+		} \
+	};
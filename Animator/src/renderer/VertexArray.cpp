@@ -5,6 +5,7 @@
 
 #include "BufferElement.hpp"
 #include "BufferLayout.hpp"
+#include "RenderState.hpp"
 
 size_t VertexArray::BufferElementTypeToOpenGLType(BufferElement::Type type)
 {
@@ -24,6 +25,21 @@ size_t VertexArray::BufferElementTypeToOpenGLType(BufferElement::Type type)
 	case BufferElement::Type::Mat3:
 	case BufferElement::Type::Mat4:
 		return GL_FLOAT;
+	case BufferElement::Type::Half2:
+	case BufferElement::Type::Half4:
+		return GL_HALF_FLOAT;
+	case BufferElement::Type::Short2N:
+	case BufferElement::Type::Short4N:
+	case BufferElement::Type::Octahedral:
+		return GL_SHORT;
+	case BufferElement::Type::UShort2N:
+		return GL_UNSIGNED_SHORT;
+	case BufferElement::Type::Byte4N:
+		return GL_BYTE;
+	case BufferElement::Type::UByte4N:
+		return GL_UNSIGNED_BYTE;
+	case BufferElement::Type::Packed1010102N:
+		return GL_INT_2_10_10_10_REV;
 	default:
 		throw std::runtime_error("Unknown element type");
 	}
@@ -36,29 +52,34 @@ VertexArray::VertexArray()
 
 VertexArray::~VertexArray()
 {
+	RenderState::ForgetVertexArray(vao);
 	glDeleteVertexArrays(1, &vao);
 }
 
 void VertexArray::Bind() const
 {
-	glBindVertexArray(vao);
+	RenderState::BindVertexArray(vao);
 }
 
 void VertexArray::Unbind() const
 {
-	glBindVertexArray(0);
+	RenderState::BindVertexArray(0);
 }
 
-void VertexArray::AddVertexBuffer(const VertexBuffer& buffer)
+void VertexArray::AddVertexBuffer(const VertexBuffer& buffer, unsigned int divisor)
 {
-	Bind();
-	buffer.Bind();
+	AddVertexBuffer(buffer.GetId(), buffer.GetLayout(), divisor);
+}
 
-	const BufferLayout& layout = buffer.GetLayout();
+void VertexArray::AddVertexBuffer(unsigned int buffer, const BufferLayout& layout, unsigned int divisor)
+{
+	Bind();
+	RenderState::BindArrayBuffer(buffer);
 
 	size_t count;
 	for (const BufferElement& element : layout.GetElements())
 	{
+		const size_t firstAttribIndex = attribArrayIndex;
 		switch (element.type)
 		{
 		case BufferElement::Type::Bool:
@@ -91,8 +112,29 @@ void VertexArray::AddVertexBuffer(const VertexBuffer& buffer)
 			);
 			attribArrayIndex++;
 			break;
+		case BufferElement::Type::Half2:
+		case BufferElement::Type::Half4:
+		case BufferElement::Type::Short2N:
+		case BufferElement::Type::Short4N:
+		case BufferElement::Type::UShort2N:
+		case BufferElement::Type::Byte4N:
+		case BufferElement::Type::UByte4N:
+		case BufferElement::Type::Packed1010102N:
+		case BufferElement::Type::Octahedral:
+			glEnableVertexAttribArray(attribArrayIndex);
+			glVertexAttribPointer(
+				attribArrayIndex,
+				element.GetComponentCount(),
+				BufferElementTypeToOpenGLType(element.type),
+				BufferElement::IsNormalizedType(element.type),
+				layout.GetStride(),
+				(const void*)element.offset
+			);
+			attribArrayIndex++;
+			break;
 		case BufferElement::Type::Mat3:
 		case BufferElement::Type::Mat4:
+			// One attribute per column of count floats
 			count = element.GetComponentCount();
 			for (size_t i = 0; i < count; i++)
 			{
@@ -105,17 +147,87 @@ void VertexArray::AddVertexBuffer(const VertexBuffer& buffer)
 					layout.GetStride(),
 					(const void*)(element.offset + sizeof(float) * count * i)
 				);
+				attribArrayIndex++;
 			}
 			break;
 		default:
 			throw std::runtime_error("Unknown element type");
 		}
+
+		if (divisor != 0)
+		{
+			for (size_t i = firstAttribIndex; i < attribArrayIndex; i++)
+			{
+				glVertexAttribDivisor(i, divisor);
+			}
+		}
 	}
 }
 
 void VertexArray::SetIndexBuffer(const IndexBuffer& buffer)
 {
-	Bind();
-	buffer.Bind();
-	Unbind();
+	SetIndexBuffer(buffer.GetId());
+}
+
+void VertexArray::SetIndexBuffer(unsigned int buffer)
+{
+	// The element buffer binding is VAO state, so draws pick it up with the VAO
+	glVertexArrayElementBuffer(vao, buffer);
+}
+
+void VertexArray::SetLayout(const BufferLayout& layout, unsigned int binding)
+{
+	for (const BufferElement& element : layout.GetElements())
+	{
+		const size_t type = BufferElementTypeToOpenGLType(element.type);
+		switch (element.type)
+		{
+		case BufferElement::Type::Bool:
+		case BufferElement::Type::Int:
+		case BufferElement::Type::Int2:
+		case BufferElement::Type::Int3:
+		case BufferElement::Type::Int4:
+			glEnableVertexArrayAttrib(vao, attribArrayIndex);
+			glVertexArrayAttribIFormat(vao, attribArrayIndex, element.GetComponentCount(), type, element.offset);
+			glVertexArrayAttribBinding(vao, attribArrayIndex, binding);
+			attribArrayIndex++;
+			break;
+		case BufferElement::Type::Mat3:
+		case BufferElement::Type::Mat4:
+			// One attribute per column
+			for (size_t i = 0; i < element.GetComponentCount(); i++)
+			{
+				glEnableVertexArrayAttrib(vao, attribArrayIndex);
+				glVertexArrayAttribFormat(
+					vao,
+					attribArrayIndex,
+					element.GetComponentCount(),
+					type,
+					element.normalized,
+					element.offset + sizeof(float) * element.GetComponentCount() * i
+				);
+				glVertexArrayAttribBinding(vao, attribArrayIndex, binding);
+				attribArrayIndex++;
+			}
+			break;
+		default:
+			glEnableVertexArrayAttrib(vao, attribArrayIndex);
+			glVertexArrayAttribFormat(
+				vao,
+				attribArrayIndex,
+				element.GetComponentCount(),
+				type,
+				element.normalized || BufferElement::IsNormalizedType(element.type),
+				element.offset
+			);
+			glVertexArrayAttribBinding(vao, attribArrayIndex, binding);
+			attribArrayIndex++;
+			break;
+		}
+	}
+}
+
+void VertexArray::SetVertexBuffer(unsigned int binding, unsigned int buffer, size_t offset, size_t stride)
+{
+	glVertexArrayVertexBuffer(vao, binding, buffer, offset, stride);
 }
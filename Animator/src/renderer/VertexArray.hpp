@@ -17,6 +17,21 @@ public:
 	void Bind() const;
 	void Unbind() const;
 
-	void AddVertexBuffer(const VertexBuffer& buffer);
+	unsigned int GetId() const { return (unsigned int)vao; }
+
+	// A non-zero divisor advances the attributes once per that many instances
+	void AddVertexBuffer(const VertexBuffer& buffer, unsigned int divisor = 0);
+
+	// Sources the layout from any buffer object, e.g. a StreamingBuffer
+	void AddVertexBuffer(unsigned int buffer, const BufferLayout& layout, unsigned int divisor = 0);
 	void SetIndexBuffer(const IndexBuffer& buffer);
+	void SetIndexBuffer(unsigned int buffer);
+
+	// Separate attribute format: the layout is described once for a binding
+	// point and buffers are attached to it, or replaced, with SetVertexBuffer
+	void SetLayout(const BufferLayout& layout, unsigned int binding = 0);
+	void SetVertexBuffer(unsigned int binding, unsigned int buffer, size_t offset, size_t stride);
+
+	// Location the next added attribute gets, the following ones are consecutive
+	void SetNextAttribIndex(size_t index) { attribArrayIndex = index; }
 };
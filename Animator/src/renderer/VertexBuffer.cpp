@@ -2,6 +2,8 @@
 
 #include <GL/glew.h>
 
+#include "RenderState.hpp"
+
 VertexBuffer::VertexBuffer(void* data, size_t size, const BufferLayout& layout)
 	: layout(layout)
 {
@@ -22,24 +24,18 @@ VertexBuffer::VertexBuffer(size_t size, const BufferLayout& layout)
 
 VertexBuffer::~VertexBuffer()
 {
+	RenderState::ForgetBuffer(buffer);
 	glDeleteBuffers(1, &buffer);
 }
 
 void VertexBuffer::Bind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	RenderState::BindArrayBuffer(buffer);
 }
 
 void VertexBuffer::Unbind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-void VertexBuffer::SetData(void* data, size_t size)
-{
-	Bind();
-	glBufferData(GL_ARRAY_BUFFER, size, data, GL_DYNAMIC_DRAW);
-	Unbind();
+	RenderState::BindArrayBuffer(0);
 }
 
 const BufferLayout& VertexBuffer::GetLayout() const
@@ -5,7 +5,7 @@
 class VertexBuffer
 {
 private:
-	size_t buffer;
+	unsigned int buffer;
 	BufferLayout layout;
 public:
 	VertexBuffer(void* data, size_t size, const BufferLayout& layout);
@@ -15,7 +15,7 @@ public:
 	void Bind() const;
 	void Unbind() const;
 
-	void SetData(void* data, size_t size);
+	unsigned int GetId() const { return buffer; }
 
 	const BufferLayout& GetLayout() const;
 };
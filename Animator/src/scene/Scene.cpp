@@ -1,5 +1,7 @@
 #include "Scene.hpp"
 
+#include <cmath>
+#include <random>
 #include <fstream>
 
 #include "../animation/Vec3AnimationClip.hpp"
@@ -22,6 +24,13 @@ const std::string Scene::SHININESS_PROPERTY_NAME = "Prism shininess";
 const std::string Scene::N_PROPERTY_NAME = "N";
 const std::string Scene::PRISM_COLOR_PROPERTY_NAME = "Prism color";
 
+const unsigned int INSTANCES_SEED = 1;
+// Side of the square the instance grid fills, centered at the origin
+const float INSTANCES_GRID_SIZE = 2.0f;
+// Scale of an instance relative to its grid cell
+const float INSTANCE_SCALE = 1.5f;
+const float INSTANCE_MAX_TIME_OFFSET = 10.0f;
+
 void Scene::SetN(int value)
 {
 	if (n == value || value < 3)
@@ -30,7 +39,110 @@ void Scene::SetN(int value)
 	}
 
 	n = value;
-	prism = Mesh::Prism(n);
+	if (!prismProcedural)
+	{
+		RequestPrism();
+	}
+}
+
+void Scene::SetPrismVertexFormat(Mesh::VertexFormat format)
+{
+	if (prismVertexFormat == format)
+	{
+		return;
+	}
+
+	prismVertexFormat = format;
+	if (!prismProcedural)
+	{
+		RequestPrism();
+	}
+}
+
+void Scene::SetPrismProcedural(bool value)
+{
+	if (prismProcedural == value)
+	{
+		return;
+	}
+
+	prismProcedural = value;
+	if (prismProcedural)
+	{
+		PrismBuilder::Cancel();
+	}
+	else
+	{
+		RequestPrism();
+	}
+}
+
+void Scene::RequestPrism()
+{
+	std::shared_ptr<Mesh> cached = PrismCache::Find(n, prismVertexFormat);
+	if (cached != nullptr)
+	{
+		prism = cached;
+		PrismBuilder::Cancel();
+		return;
+	}
+
+	// The current prism stays until the new one is built
+	PrismBuilder::Request(n, prismVertexFormat);
+}
+
+void Scene::SetInstancesCount(int value)
+{
+	if (value < 0)
+	{
+		value = 0;
+	}
+	else if (value > MAX_INSTANCES)
+	{
+		value = MAX_INSTANCES;
+	}
+
+	if (instancesCount == value && instances.size() == size_t(value))
+	{
+		return;
+	}
+
+	instancesCount = value;
+	GenerateInstances();
+}
+
+void Scene::GenerateInstances()
+{
+	std::mt19937 random(INSTANCES_SEED);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	const size_t side = size_t(std::ceil(std::sqrt(double(instancesCount))));
+	const float cell = side == 0 ? 0.0f : INSTANCES_GRID_SIZE / side;
+	instances.resize(instancesCount);
+	instancesN.resize(instancesCount);
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		const glm::vec3 position(
+			(i % side + 0.5f) * cell - INSTANCES_GRID_SIZE / 2,
+			(i / side + 0.5f) * cell - INSTANCES_GRID_SIZE / 2,
+			0.0f
+		);
+
+		Instance& instance = instances[i];
+		instance.Transform = glm::mat4(cell * INSTANCE_SCALE);
+		instance.Transform[3] = glm::vec4(position, 1.0f);
+		instance.Color = glm::vec4(unit(random), unit(random), unit(random), 1.0f);
+		instance.TimeOffset = unit(random) * INSTANCE_MAX_TIME_OFFSET;
+	}
+
+	// Drawn last so the colors and phases do not depend on them
+	std::uniform_int_distribution<int> sides(VARYING_N_MIN, VARYING_N_MAX);
+	for (size_t i = 0; i < instancesN.size(); i++)
+	{
+		instancesN[i] = sides(random);
+	}
+
+	instancesVersion = NextChangeVersion();
 }
 
 Scene* Scene::CreateDefault()
@@ -46,7 +158,6 @@ Scene* Scene::CreateDefault()
 	scene->n = 3;
 	scene->PrismColor = { 105.0f / 255, 184.0f / 255, 230.0f / 255 };
 	scene->Texture = Texture::Load("assets/textures/diffuse.jpg");
-	scene->prism = Mesh::Prism(scene->n);
 	
 	scene->Lightning = false;
 	scene->AmbientColor = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -59,18 +170,30 @@ Scene* Scene::CreateDefault()
 	return scene;
 }
 
-Scene::Scene()
+Scene::Scene() : prism(PrismCache::Get(n))
 {
-	animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(POSITION_PROPERTY_NAME, &Position, glm::vec3{ 0.0f, 0.0f, -1.0f });
-	animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(ROTATION_PROPERTY_NAME, &Rotation);
-	animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(SCALE_PROPERTY_NAME, &Scale, glm::vec3{ 1.0f, 1.0f, 1.0f });
-	animator.RegisterProperty<int, ParameterAnimationClip>(N_PROPERTY_NAME, [this](int n) { this->SetN(n); });
-	animator.RegisterProperty<glm::vec3, Color3AnimationClip>(PRISM_COLOR_PROPERTY_NAME, &PrismColor, glm::vec3(1.0f, 1.0f, 1.0f));
-	animator.RegisterProperty<glm::vec4, Color4AnimationClip>(AMBIENT_COLOR_PROPERTY_NAME, &AmbientColor, glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f });
-	animator.RegisterProperty<glm::vec4, Color4AnimationClip>(DIFFUSE_COLOR_PROPERTY_NAME, &DiffuseColor, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
-	animator.RegisterProperty<glm::vec4, Color4AnimationClip>(LIGHT_SPECULAR_COLOR_PROPERTY_NAME, &LightSpecularColor, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
-	animator.RegisterProperty<glm::vec4, Color4AnimationClip>(PRISM_SPECULAR_COLOR_PROPERTY_NAME, &PrismSpecularColor, glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f });
-	animator.RegisterProperty<float, ShininessAnimationClip>(SHININESS_PROPERTY_NAME, &Shininess);
+	propertyIds.Position = animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(POSITION_PROPERTY_NAME, &Position, glm::vec3{ 0.0f, 0.0f, -1.0f });
+	propertyIds.Rotation = animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(ROTATION_PROPERTY_NAME, &Rotation);
+	propertyIds.Scale = animator.RegisterProperty<glm::vec3, Vec3AnimationClip>(SCALE_PROPERTY_NAME, &Scale, glm::vec3{ 1.0f, 1.0f, 1.0f });
+	propertyIds.N = animator.RegisterProperty<int, ParameterAnimationClip, Scene, &Scene::SetN>(N_PROPERTY_NAME, this);
+	propertyIds.PrismColor = animator.RegisterProperty<glm::vec3, Color3AnimationClip>(PRISM_COLOR_PROPERTY_NAME, &PrismColor, glm::vec3(1.0f, 1.0f, 1.0f));
+	propertyIds.AmbientColor = animator.RegisterProperty<glm::vec4, Color4AnimationClip>(AMBIENT_COLOR_PROPERTY_NAME, &AmbientColor, glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f });
+	propertyIds.DiffuseColor = animator.RegisterProperty<glm::vec4, Color4AnimationClip>(DIFFUSE_COLOR_PROPERTY_NAME, &DiffuseColor, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+	propertyIds.LightSpecularColor = animator.RegisterProperty<glm::vec4, Color4AnimationClip>(LIGHT_SPECULAR_COLOR_PROPERTY_NAME, &LightSpecularColor, glm::vec4{ 1.0f, 1.0f, 1.0f, 1.0f });
+	propertyIds.PrismSpecularColor = animator.RegisterProperty<glm::vec4, Color4AnimationClip>(PRISM_SPECULAR_COLOR_PROPERTY_NAME, &PrismSpecularColor, glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f });
+	propertyIds.Shininess = animator.RegisterProperty<float, ShininessAnimationClip>(SHININESS_PROPERTY_NAME, &Shininess);
+}
+
+void Scene::Sync()
+{
+	transform.Set(Position, Rotation, Scale);
+	lighting.Track(std::make_tuple(AmbientColor, DiffuseColor, LightSpecularColor, PrismSpecularColor, Shininess));
+
+	std::shared_ptr<Mesh> built = PrismBuilder::Update();
+	if (built != nullptr)
+	{
+		prism = built;
+	}
 }
 
 void Scene::LoadFromFile(const std::string& path)
@@ -81,6 +204,11 @@ void Scene::LoadFromFile(const std::string& path)
 		std::ifstream stream(path);
 		cereal::JSONInputArchive archive(stream);
 		archive(cereal::make_nvp<cereal::JSONInputArchive>("Scene", *scene));
+		if (scene->Texture != nullptr)
+		{
+			scene->Texture->CompleteLoad();
+		}
+
 		if (current != nullptr)
 		{
 			delete current;
@@ -88,6 +216,7 @@ void Scene::LoadFromFile(const std::string& path)
 
 		current = scene;
 		Scene::path = path;
+		PrismBuilder::Cancel();
 		Debug::LogFormat(Debug::MessageType::Info, "Scene loaded. Path - \"%s\"", path.c_str());
 	}
 	catch (const std::exception& error)
@@ -122,4 +251,30 @@ void Scene::SetDefault()
 
 	current = CreateDefault();
 	path = "";
+	PrismBuilder::Cancel();
+}
+
+void Scene::SetInstancingBenchmark()
+{
+	SetDefault();
+	current->Position = { 0.0f, 0.0f, -0.5f };
+	current->SetInstancesCount(INSTANCING_BENCHMARK_INSTANCES);
+	current->SetInstanced(true);
+	Debug::LogFormat(Debug::MessageType::Info, "Instancing benchmark scene. Instances - %d", INSTANCING_BENCHMARK_INSTANCES);
+}
+
+void Scene::SetBatchingBenchmark()
+{
+	SetDefault();
+	current->Position = { 0.0f, 0.0f, -0.5f };
+	current->SetInstancesCount(BATCHING_BENCHMARK_INSTANCES);
+	current->SetInstanced(true);
+	current->SetInstancesVaryingN(true);
+	Debug::LogFormat(
+		Debug::MessageType::Info,
+		"Batching benchmark scene. Instances - %d, N - %d to %d",
+		BATCHING_BENCHMARK_INSTANCES,
+		VARYING_N_MIN,
+		VARYING_N_MAX
+	);
 }
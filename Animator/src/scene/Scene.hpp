@@ -1,13 +1,19 @@
 #pragma once
 
 #include <memory>
+#include <tuple>
+#include <vector>
 #include <glm/glm.hpp>
 #include "../ConfiguredCereal.hpp"
 #include "../SerializationRules.hpp"
 
 #include "../Texture.hpp"
 #include "../mesh/Mesh.hpp"
+#include "../mesh/PrismCache.hpp"
+#include "../mesh/PrismBuilder.hpp"
 #include "../animation/Animator.hpp"
+#include "../math/Transform.hpp"
+#include "../ChangeTracker.hpp"
 
 enum class RenderMode
 {
@@ -18,6 +24,29 @@ enum class RenderMode
 
 class Scene
 {
+public:
+	// Layout of the per-instance attribute buffer, see InstancedMesh.vert.glsl
+	struct Instance
+	{
+		glm::mat4 Transform;
+		glm::vec4 Color;
+		// Shifts the phase of the animation played in the shader
+		float TimeOffset;
+	};
+
+	struct PropertyIds
+	{
+		Animator::PropertyId Position;
+		Animator::PropertyId Rotation;
+		Animator::PropertyId Scale;
+		Animator::PropertyId AmbientColor;
+		Animator::PropertyId DiffuseColor;
+		Animator::PropertyId LightSpecularColor;
+		Animator::PropertyId PrismSpecularColor;
+		Animator::PropertyId Shininess;
+		Animator::PropertyId N;
+		Animator::PropertyId PrismColor;
+	};
 private:
 	static Scene* current;
 
@@ -25,9 +54,28 @@ private:
 
 	static Scene* CreateDefault();
 
+	void RequestPrism();
+	void GenerateInstances();
+
 	Animator animator;
+	PropertyIds propertyIds;
 	int n = 3;
-	Mesh prism;
+	Mesh::VertexFormat prismVertexFormat = Mesh::VertexFormat::Full;
+	bool prismProcedural = false;
+	std::shared_ptr<Mesh> prism;
+
+	bool instanced = false;
+	int instancesCount = 0;
+	std::vector<Instance> instances;
+	// Side counts of the instances when they vary
+	std::vector<int> instancesN;
+	bool instancesVaryingN = false;
+	size_t instancesVersion = 0;
+
+	typedef std::tuple<glm::vec4, glm::vec4, glm::vec4, glm::vec4, float> LightingInputs;
+
+	Transform transform;
+	ChangeTracker<LightingInputs> lighting;
 public:
 	static const std::string POSITION_PROPERTY_NAME;
 	static const std::string ROTATION_PROPERTY_NAME;
@@ -40,6 +88,15 @@ public:
 	static const std::string N_PROPERTY_NAME;
 	static const std::string PRISM_COLOR_PROPERTY_NAME;
 
+	// The streamed commands of batched instances are sized for it
+	static const int MAX_INSTANCES = 1000000;
+	static const int INSTANCING_BENCHMARK_INSTANCES = 100000;
+	static const int BATCHING_BENCHMARK_INSTANCES = 10000;
+
+	// Side counts of instances with varying N
+	static const int VARYING_N_MIN = 3;
+	static const int VARYING_N_MAX = 32;
+
 	Scene();
 
 	glm::vec3 Position;
@@ -55,8 +112,36 @@ public:
 	
 	int GetN() const { return n; }
 	void SetN(int value);
+
+	Mesh::VertexFormat GetPrismVertexFormat() const { return prismVertexFormat; }
+	void SetPrismVertexFormat(Mesh::VertexFormat format);
 	
-	Mesh& GetPrism() { return prism; }
+	// Drawn from gl_VertexID without a mesh, N changes do not rebuild the prism then
+	bool IsPrismProcedural() const { return prismProcedural; }
+	void SetPrismProcedural(bool value);
+
+	// Lags behind N while procedural or being built
+	Mesh& GetPrism() { return *prism; }
+
+	// Replaces the single prism with a grid of procedural prisms with N sides,
+	// each with its own color and animation phase. The transform applies to
+	// the whole grid
+	bool IsInstanced() const { return instanced; }
+	void SetInstanced(bool value) { instanced = value; }
+
+	// The instances are regenerated with a fixed seed when the count changes,
+	// the count is clamped to [0; MAX_INSTANCES]
+	int GetInstancesCount() const { return instancesCount; }
+	void SetInstancesCount(int value);
+
+	// Gives every instance its own N between VARYING_N_MIN and VARYING_N_MAX,
+	// the instances are then prisms built as meshes instead of procedural ones
+	bool IsInstancesVaryingN() const { return instancesVaryingN; }
+	void SetInstancesVaryingN(bool value) { instancesVaryingN = value; }
+
+	const std::vector<Instance>& GetInstances() const { return instances; }
+	const std::vector<int>& GetInstancesN() const { return instancesN; }
+	size_t GetInstancesVersion() const { return instancesVersion; }
 
 	bool Lightning = false;
 	glm::vec4 AmbientColor;
@@ -67,7 +152,16 @@ public:
 
 	bool ShowNormals = false;
 
+	// Brings the derived render data below up to date with the fields above,
+	// recomputing only what depends on a changed field, and takes a prism
+	// built in the background once it is complete
+	void Sync();
+
+	const Transform& GetTransform() const { return transform; }
+	size_t GetLightingVersion() const { return lighting.GetVersion(); }
+
 	Animator& GetAnimator() { return animator; }
+	const PropertyIds& GetPropertyIds() const { return propertyIds; }
 
 	static Scene& Current() { return *current; }
 
@@ -79,6 +173,12 @@ public:
 
 	static void SetDefault();
 
+	// Default scene with INSTANCING_BENCHMARK_INSTANCES instanced triangular prisms
+	static void SetInstancingBenchmark();
+
+	// Default scene with BATCHING_BENCHMARK_INSTANCES instanced prisms with varying N
+	static void SetBatchingBenchmark();
+
 	template<class Archive>
 	void Save(Archive& archive) const;
 
@@ -93,6 +193,11 @@ void Scene::Save(Archive& archive) const
 	archive(CEREAL_NVP(Rotation));
 	archive(CEREAL_NVP(Scale));
 	archive(CEREAL_NVP_("N", n));
+	archive(CEREAL_NVP_("PrismVertexFormat", prismVertexFormat));
+	archive(CEREAL_NVP_("PrismProcedural", prismProcedural));
+	archive(CEREAL_NVP_("Instanced", instanced));
+	archive(CEREAL_NVP_("InstancesCount", instancesCount));
+	archive(CEREAL_NVP_("InstancesVaryingN", instancesVaryingN));
 	archive(CEREAL_NVP(TimeScale));
 	archive(CEREAL_NVP(RenderMode));
 	archive(CEREAL_NVP(PrismColor));
@@ -120,7 +225,14 @@ void Scene::Load(Archive& archive)
 		n = 3;
 	}
 
-	prism = Mesh::Prism(n);
+	LoadOptionalNVP(archive, "PrismVertexFormat", prismVertexFormat);
+	LoadOptionalNVP(archive, "PrismProcedural", prismProcedural);
+	LoadOptionalNVP(archive, "Instanced", instanced);
+	int instancesCount = 0;
+	LoadOptionalNVP(archive, "InstancesCount", instancesCount);
+	SetInstancesCount(instancesCount);
+	LoadOptionalNVP(archive, "InstancesVaryingN", instancesVaryingN);
+	prism = PrismCache::Get(n, prismVertexFormat);
 	this->n = n;
 	archive(CEREAL_NVP(TimeScale));
 	archive(CEREAL_NVP(RenderMode));
@@ -73,10 +73,16 @@ void AnimatorWindow::Draw()
 			{
 				if (!animator.IsAnimatedProperty(i))
 				{
-					const std::string& name = animator.GetPropertyName(i);
-					if (ImGui::MenuItem(name.c_str()))
+					if (ImGui::BeginMenu(animator.GetPropertyName(i).c_str()))
 					{
-						animator.ActivatePropertyAnimation(name);
+						for (int type = 0; type < Animator::CLIP_TYPES_COUNT; type++)
+						{
+							if (ImGui::MenuItem(Animator::CLIP_TYPE_NAMES[type]))
+							{
+								animator.ActivatePropertyAnimation(i, (Animator::ClipType)type);
+							}
+						}
+						ImGui::EndMenu();
 					}
 				}
 			}
@@ -106,6 +112,8 @@ void AnimatorWindow::Draw()
 		animator.SetAnimationMode((Animator::Mode)modeIndex);
 	}
 
+	ImGui::Checkbox("Baked playback", &animator.Baked);
+
 	char buffer[20];
 	for (size_t i = 0; i < animator.GetAnimatedPropertiesCount(); i++)
 	{
@@ -119,7 +127,7 @@ void AnimatorWindow::Draw()
 		sprintf_s(buffer, "x##%d", i);
 		if (ImGui::Button(buffer, ImVec2{ lineHeight, lineHeight }))
 		{
-			animator.DeactivatePropertyAnimation(clip->GetPropertyName());
+			animator.DeactivatePropertyAnimation(animator.GetAnimatedPropertyId(i));
 			i--;
 		}
 		if (open)
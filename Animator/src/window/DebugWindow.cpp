@@ -1,9 +1,24 @@
 #include "DebugWindow.hpp"
 
 #include <memory>
+#include <vector>
+#include <string>
 
 #include "../CustomUI.hpp"
 
+DebugWindow::DebugWindow() : Window("Debug")
+{
+	std::vector<std::string> paths;
+	paths.push_back("assets/textures/debug_window/error.png");
+	paths.push_back("assets/textures/debug_window/info.png");
+	paths.push_back("assets/textures/debug_window/warning.png");
+
+	std::vector<std::shared_ptr<Texture>> icons = Texture::Load(paths);
+	error = icons[0];
+	info = icons[1];
+	warning = icons[2];
+}
+
 void DebugWindow::DrawIcon(std::shared_ptr<Texture> texture)
 {
 	ImGui::Image(
@@ -9,9 +9,9 @@
 class DebugWindow : public Window
 {
 private:
-	const std::shared_ptr<Texture> error = Texture::Load("assets/textures/debug_window/error.png");
-	const std::shared_ptr<Texture> info = Texture::Load("assets/textures/debug_window/info.png");
-	const std::shared_ptr<Texture> warning = Texture::Load("assets/textures/debug_window/warning.png");
+	std::shared_ptr<Texture> error;
+	std::shared_ptr<Texture> info;
+	std::shared_ptr<Texture> warning;
 
 	float listPercent = 0.7f;
 	float messagePercent = 0.3f;
@@ -24,7 +24,7 @@ private:
 	void ListPart(float height);
 	void MessagePart(float height);
 public:
-	DebugWindow() : Window("Debug") { }
+	DebugWindow();
 
 	void Draw() override;
 };
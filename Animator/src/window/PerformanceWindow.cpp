@@ -2,10 +2,23 @@
 
 #include <cmath>
 #include <stdexcept>
+#include <random>
 #include <algorithm>
+#include <GL/glew.h>
 #include <imgui/imgui.h>
 
+#include "../Debug.hpp"
 #include "../scene/Scene.hpp"
+#include "../mesh/Mesh.hpp"
+#include "../mesh/PrismCache.hpp"
+#include "../mesh/PrismBuilder.hpp"
+#include "../jobs/JobSystem.hpp"
+#include "../renderer/RenderState.hpp"
+
+// Largest vertex difference accepted between procedural and generated prisms
+const float PROCEDURAL_PRISM_TOLERANCE = 1e-5f;
+
+const unsigned int RENDER_QUEUE_BENCHMARK_SEED = 12345;
 
 PerformanceWindow::Data* PerformanceWindow::Data::data = nullptr;
 
@@ -50,7 +63,8 @@ void PerformanceWindow::Data::Add(
 	const std::chrono::milliseconds& updateTime,
 	const std::chrono::milliseconds& renderTime,
 	const std::chrono::milliseconds& uiTime,
-	double fps
+	double fps,
+	size_t streamedBytes
 )
 {
 	if (stopped)
@@ -69,6 +83,7 @@ void PerformanceWindow::Data::Add(
 	this->updateTime = valueUpdateTime;
 	this->renderTime = valueRenderTime;
 	this->uiTime = valueUITime;
+	this->streamedBytes = streamedBytes;
 
 	if (iteration % 30 == 0)
 	{
@@ -96,12 +111,14 @@ void PerformanceWindow::Data::Add(
 	maxUpdateTime = std::max(maxUpdateTime, valueUpdateTime);
 	maxRenderTime = std::max(maxRenderTime, valueRenderTime);
 	maxUITime = std::max(maxUITime, valueUITime);
+	maxStreamedBytes = std::max(maxStreamedBytes, streamedBytes);
 
 	totalFPS += fps;
 	totalFrameTime += frameTime;
 	totalUpdateTime += valueUpdateTime;
 	totalRenderTime += valueRenderTime;
 	totalUITime += valueUITime;
+	totalStreamedBytes += streamedBytes;
 }
 
 void PerformanceWindow::Data::Resume()
@@ -138,6 +155,7 @@ void PerformanceWindow::Data::Reset()
 	data->updateTime = 0;
 	data->renderTime = 0;
 	data->uiTime = 0;
+	data->streamedBytes = 0;
 
 	data->minFPS = DBL_MAX;
 	data->minFrameTime = LLONG_MAX;
@@ -150,12 +168,14 @@ void PerformanceWindow::Data::Reset()
 	data->maxUpdateTime = 0;
 	data->maxRenderTime = 0;
 	data->maxUITime = 0;
+	data->maxStreamedBytes = 0;
 
 	data->totalFPS = 0;
 	data->totalFrameTime = 0;
 	data->totalUpdateTime = 0;
 	data->totalRenderTime = 0;
 	data->totalUITime = 0;
+	data->totalStreamedBytes = 0;
 }
 
 const float* PerformanceWindow::Data::GetFPSHistory()
@@ -218,6 +238,12 @@ long long PerformanceWindow::Data::GetUITime()
 	return data->uiTime;
 }
 
+size_t PerformanceWindow::Data::GetStreamedBytes()
+{
+	ThrowIfNoData();
+	return data->streamedBytes;
+}
+
 double PerformanceWindow::Data::GetMinFPS()
 {
 	ThrowIfNoData();
@@ -278,6 +304,12 @@ long long PerformanceWindow::Data::GetMaxUITime()
 	return data->maxUITime;
 }
 
+size_t PerformanceWindow::Data::GetMaxStreamedBytes()
+{
+	ThrowIfNoData();
+	return data->maxStreamedBytes;
+}
+
 double PerformanceWindow::Data::GetTotalFPS()
 {
 	ThrowIfNoData();
@@ -338,7 +370,109 @@ double PerformanceWindow::Data::GetAverageUITime()
 	return double(data->totalUITime) / data->iteration;
 }
 
-PerformanceWindow::PerformanceWindow() : Window("Performance", false) { }
+double PerformanceWindow::Data::GetAverageStreamedBytes()
+{
+	ThrowIfNoData();
+	return double(data->totalStreamedBytes) / data->iteration;
+}
+
+PerformanceWindow::PerformanceWindow(const RenderQueue& renderQueue, StreamingBuffer& streamingBuffer)
+	: Window("Performance", false), renderQueue(renderQueue), streamingBuffer(streamingBuffer) { }
+
+void PerformanceWindow::BenchmarkPrismGeneration()
+{
+	for (size_t n = 1000; n <= 1000000; n *= 10)
+	{
+		double best = DBL_MAX;
+		for (size_t run = 0; run < BENCHMARK_RUNS; run++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			std::vector<Vertex> verticies;
+			std::vector<uint32_t> indices;
+			Mesh::GeneratePrism(n, verticies, indices);
+			auto stop = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+		}
+
+		Debug::LogFormat(
+			Debug::MessageType::Info,
+			"Prism generation. N - %zu, time - %.3f ms, workers - %zu",
+			n,
+			best,
+			JobSystem::GetWorkersCount()
+		);
+	}
+}
+
+void PerformanceWindow::ValidateProceduralPrism()
+{
+	const size_t counts[] = { 3, 4, 5, 17, 100, 1000, 100000, 1000000 };
+	for (size_t n : counts)
+	{
+		const float error = Mesh::ValidateProceduralPrism(n);
+		Debug::LogFormat(
+			error <= PROCEDURAL_PRISM_TOLERANCE ? Debug::MessageType::Info : Debug::MessageType::Error,
+			"Procedural prism validation. N - %zu, max error - %g",
+			n,
+			error
+		);
+	}
+}
+
+void PerformanceWindow::BenchmarkRenderQueue()
+{
+	// Fixed seed, every run submits the same items
+	std::mt19937 random(RENDER_QUEUE_BENCHMARK_SEED);
+	std::vector<RenderQueue::Item> items(RENDER_QUEUE_BENCHMARK_ITEMS);
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		RenderQueue::Item& item = items[i];
+		item.program = 1 + random() % 4;
+		item.geometry = RenderQueue::Geometry{ 1 + random() % 16, GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, 36, 0, 0, 0, 0, 0 };
+		item.texture = 1 + random() % 8;
+		item.polygonMode = random() % 2 == 0 ? GL_FILL : GL_LINE;
+		item.uniformBuffer = 1;
+		item.uniformOffset = i * 256;
+		item.uniformSize = 256;
+	}
+
+	RenderQueue queue;
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		queue.Submit(items[i]);
+	}
+
+	RenderQueue::NullBackend unsortedBackend;
+	const RenderQueue::Statistics unsorted = queue.Execute(unsortedBackend);
+
+	double best = DBL_MAX;
+	RenderQueue::Statistics sorted;
+	for (size_t run = 0; run < BENCHMARK_RUNS; run++)
+	{
+		queue.Clear();
+		for (size_t i = 0; i < items.size(); i++)
+		{
+			queue.Submit(items[i]);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		RenderQueue::NullBackend backend;
+		queue.Sort();
+		sorted = queue.Execute(backend);
+		auto stop = std::chrono::high_resolution_clock::now();
+		best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+	}
+
+	Debug::LogFormat(
+		Debug::MessageType::Info,
+		"Render queue. Items - %zu, state changes unsorted - %zu, sorted - %zu (avoided - %zu), time - %.3f ms",
+		sorted.items,
+		unsorted.issuedChanges,
+		sorted.issuedChanges,
+		sorted.avoidedChanges,
+		best
+	);
+}
 
 void PerformanceWindow::Draw()
 {
@@ -380,8 +514,67 @@ void PerformanceWindow::Draw()
 		PerformanceWindow::Data::GetMaxUITime()
 	);
 
+	ImGui::Text(
+		"Streamed: %zu bytes per frame (avg: %lld; max: %zu)",
+		PerformanceWindow::Data::GetStreamedBytes(),
+		std::llround(PerformanceWindow::Data::GetAverageStreamedBytes()),
+		PerformanceWindow::Data::GetMaxStreamedBytes()
+	);
+	ImGui::Text(
+		"Streaming buffer: peak %zu of %zu bytes per region, %zu waits for the GPU",
+		streamingBuffer.GetPeakFrameBytes(),
+		streamingBuffer.GetRegionSize(),
+		streamingBuffer.GetWaits()
+	);
+	const RenderQueue::Statistics& queueStatistics = renderQueue.GetStatistics();
+	ImGui::Text(
+		"Render queue: %zu items, %zu state changes issued, %zu avoided",
+		queueStatistics.items,
+		queueStatistics.issuedChanges,
+		queueStatistics.avoidedChanges
+	);
+	ImGui::Text("Draw calls: %zu drawing %zu meshes", queueStatistics.drawCalls, queueStatistics.draws);
+	ImGui::Text(
+		"State changes: %zu issued, %zu skipped per frame",
+		RenderState::GetIssuedChanges(),
+		RenderState::GetSkippedChanges()
+	);
+
 	Scene& scene = Scene::Current();
-	ImGui::Text("Verticies: %zu", scene.GetPrism().GetVerticies().size());
+	ImGui::Text("Verticies: %zu", scene.GetPrism().GetVerticiesCount());
+	ImGui::Text("Indices: %zu", scene.GetPrism().GetIndicesCount());
+	ImGui::Text(
+		"Prism cache: %zu meshes, %.2f of %.2f MB (hits: %zu; misses: %zu; evictions: %zu)",
+		PrismCache::GetMeshesCount(),
+		PrismCache::GetSize() / (1024.0 * 1024.0),
+		PrismCache::GetCapacity() / (1024.0 * 1024.0),
+		PrismCache::GetHits(),
+		PrismCache::GetMisses(),
+		PrismCache::GetEvictions()
+	);
+	ImGui::Text(
+		"Prism builds: %s (started: %zu; skipped: %zu; completed: %zu)",
+		PrismBuilder::IsBuilding() ? "building" : "idle",
+		PrismBuilder::GetStarted(),
+		PrismBuilder::GetSkipped(),
+		PrismBuilder::GetCompleted()
+	);
+	const GeometryArena& arena = Mesh::GetArena(scene.GetPrismVertexFormat());
+	ImGui::Text(
+		"Geometry arena: %zu meshes, %.2f of %.2f MB (growths: %zu)",
+		arena.GetMeshesCount(),
+		arena.GetUsed() / (1024.0 * 1024.0),
+		arena.GetCapacity() / (1024.0 * 1024.0),
+		arena.GetGrowths()
+	);
+	ImGui::Text(
+		"Jobs: %zu workers, %zu queued (peak: %zu; executed: %zu; stolen: %zu)",
+		JobSystem::GetWorkersCount(),
+		JobSystem::GetQueuedJobs(),
+		JobSystem::GetPeakQueuedJobs(),
+		JobSystem::GetExecutedJobs(),
+		JobSystem::GetStolenJobs()
+	);
 
 	ImGui::PlotLines("FPS", PerformanceWindow::Data::GetFPSHistory(), PerformanceWindow::Data::HISTORY_SIZE);
 	ImGui::PlotLines("Frame time", PerformanceWindow::Data::GetFrameTimeHistory(), PerformanceWindow::Data::HISTORY_SIZE);
@@ -392,6 +585,42 @@ void PerformanceWindow::Draw()
 	if (ImGui::Button("Reset"))
 	{
 		PerformanceWindow::Data::Reset();
+		PrismCache::ResetStatistics();
+		PrismBuilder::ResetStatistics();
+		JobSystem::ResetStatistics();
+		streamingBuffer.ResetStatistics();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Benchmark prism generation"))
+	{
+		BenchmarkPrismGeneration();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Validate procedural prism"))
+	{
+		ValidateProceduralPrism();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Benchmark render queue"))
+	{
+		BenchmarkRenderQueue();
+	}
+
+	if (ImGui::Button("Instancing benchmark scene"))
+	{
+		// Frame statistics restart so the averages cover only the benchmark scene
+		Scene::SetInstancingBenchmark();
+		PerformanceWindow::Data::Reset();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::Button("Batching benchmark scene"))
+	{
+		Scene::SetBatchingBenchmark();
+		PerformanceWindow::Data::Reset();
 	}
 
 	ImGui::SameLine();
@@ -5,6 +5,8 @@
 #include <vector>
 
 #include "Window.hpp"
+#include "../renderer/RenderQueue.hpp"
+#include "../renderer/StreamingBuffer.hpp"
 
 class PerformanceWindow : public Window
 {
@@ -29,6 +31,7 @@ public:
 		long long updateTime = 0;
 		long long renderTime = 0;
 		long long uiTime = 0;
+		size_t streamedBytes = 0;
 
 		double minFPS = DBL_MAX;
 		long long minFrameTime = LLONG_MAX;
@@ -41,12 +44,14 @@ public:
 		long long maxUpdateTime = 0;
 		long long maxRenderTime = 0;
 		long long maxUITime = 0;
+		size_t maxStreamedBytes = 0;
 
 		double totalFPS = 0;
 		long long totalFrameTime = 0;
 		long long totalUpdateTime = 0;
 		long long totalRenderTime = 0;
 		long long totalUITime = 0;
+		long long totalStreamedBytes = 0;
 
 		static PerformanceWindow::Data* data;
 
@@ -59,7 +64,8 @@ public:
 			const std::chrono::milliseconds& updateTime,
 			const std::chrono::milliseconds& renderTime,
 			const std::chrono::milliseconds& uiTime,
-			double fps
+			double fps,
+			size_t streamedBytes
 		);
 
 		static void Resume();
@@ -80,6 +86,7 @@ public:
 		static long long GetUpdateTime();
 		static long long GetRenderTime();
 		static long long GetUITime();
+		static size_t GetStreamedBytes();
 
 		static double GetMinFPS();
 		static long long GetMinFrameTime();
@@ -92,6 +99,7 @@ public:
 		static long long GetMaxUpdateTime();
 		static long long GetMaxRenderTime();
 		static long long GetMaxUITime();
+		static size_t GetMaxStreamedBytes();
 
 		static double GetTotalFPS();
 		static long long GetTotalFrameTime();
@@ -104,9 +112,26 @@ public:
 		static double GetAverageUpdateTime();
 		static double GetAverageRenderTime();
 		static double GetAverageUITime();
+		static double GetAverageStreamedBytes();
 	};
 
-	PerformanceWindow();
+	static const size_t BENCHMARK_RUNS = 5;
+	static const size_t RENDER_QUEUE_BENCHMARK_ITEMS = 10000;
+private:
+	const RenderQueue& renderQueue;
+	StreamingBuffer& streamingBuffer;
+public:
+	PerformanceWindow(const RenderQueue& renderQueue, StreamingBuffer& streamingBuffer);
 
 	void Draw() override;
+
+	// Logs the best of several prism vertex generations for growing N
+	static void BenchmarkPrismGeneration();
+
+	// Compares the procedural prism with the generated one for growing N and logs the differences
+	static void ValidateProceduralPrism();
+
+	// Logs the state changes of a fixed random queue executed unsorted and
+	// sorted with the null backend, and the best sort and execute time
+	static void BenchmarkRenderQueue();
 };